@@ -0,0 +1,281 @@
+#include <cstdio>
+#include "ExpressionGenerator.hpp"
+
+const std::vector<ExpressionGenerator::Shape> ExpressionGenerator::shapes = {
+    Shape::DeepNesting,
+    Shape::WideSum,
+    Shape::ManyVariables,
+    Shape::FunctionHeavy,
+    Shape::LogicHeavy,
+    Shape::LongLiterals
+};
+
+ExpressionGenerator::ExpressionGenerator(uint64_t seed) :
+    m_engine(seed)
+{
+
+}
+
+GeneratedExpression ExpressionGenerator::generate(Shape shape, std::size_t size)
+{
+    GeneratedExpression result;
+    result.usesLogic = false;
+
+    switch (shape)
+    {
+    case Shape::DeepNesting:
+        result.text = deepNesting(size);
+        result.variables = {"x"};
+        break;
+
+    case Shape::WideSum:
+        result.text = wideSum(size);
+        result.variables = {"x"};
+        break;
+
+    case Shape::ManyVariables:
+        result.text = manyVariables(size, result.variables);
+        break;
+
+    case Shape::FunctionHeavy:
+        result.text = functionHeavy(size);
+        result.variables = {"x"};
+        break;
+
+    case Shape::LogicHeavy:
+        result.text = logicHeavy(size);
+        result.variables = {"x"};
+        result.usesLogic = true;
+        break;
+
+    case Shape::LongLiterals:
+        result.text = longLiterals(size);
+        result.variables = {"x"};
+        break;
+    }
+
+    return result;
+}
+
+const char* ExpressionGenerator::shapeName(Shape shape)
+{
+    switch (shape)
+    {
+    case Shape::DeepNesting:
+        return "deep_nesting";
+    case Shape::WideSum:
+        return "wide_sum";
+    case Shape::ManyVariables:
+        return "many_variables";
+    case Shape::FunctionHeavy:
+        return "function_heavy";
+    case Shape::LogicHeavy:
+        return "logic_heavy";
+    case Shape::LongLiterals:
+        return "long_literals";
+    }
+
+    return "unknown";
+}
+
+std::string ExpressionGenerator::deepNesting(std::size_t size)
+{
+    // (1.234 + (5.678 * (... x)))
+    std::string result;
+
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        result += '(';
+        result += literal();
+        result += ' ';
+        result += binaryOperator();
+        result += ' ';
+    }
+
+    result += 'x';
+    result.append(size, ')');
+
+    return result;
+}
+
+std::string ExpressionGenerator::wideSum(std::size_t size)
+{
+    // 1.234 * x + 5.678 * x + ...
+    std::string result;
+
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        if (i > 0)
+        {
+            result += " + ";
+        }
+
+        result += literal();
+        result += " * x";
+    }
+
+    return result;
+}
+
+std::string ExpressionGenerator::manyVariables(std::size_t size,
+                                               std::vector<std::string>& variables)
+{
+    // v0 * v1 + v2 - ...
+    std::string result;
+
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        variables.push_back("v" + std::to_string(i));
+
+        if (i > 0)
+        {
+            result += ' ';
+            result += binaryOperator();
+            result += ' ';
+        }
+
+        result += variables.back();
+    }
+
+    return result;
+}
+
+std::string ExpressionGenerator::functionHeavy(std::size_t size)
+{
+    // Functions, that have the same meaning
+    // in both libraries.
+    static const char* unary[] = {
+        "sin", "cos", "tan", "sqrt", "abs",
+        "floor", "ceil", "sinh", "cosh", "tanh"
+    };
+
+    // sin(cos(x) + 1.234) + atan2(x, 5.678) + ...
+    std::string result;
+
+    std::size_t calls = 0;
+
+    while (calls < size)
+    {
+        if (calls > 0)
+        {
+            result += " + ";
+        }
+
+        if (uniform(4) == 0)
+        {
+            result += "atan2(x, ";
+            result += literal();
+            result += ')';
+
+            ++calls;
+            continue;
+        }
+
+        auto outer = unary[uniform(std::size(unary))];
+        auto inner = unary[uniform(std::size(unary))];
+
+        result += outer;
+        result += '(';
+        result += inner;
+        result += "(x) + ";
+        result += literal();
+        result += ')';
+
+        calls += 2;
+    }
+
+    return result;
+}
+
+std::string ExpressionGenerator::logicHeavy(std::size_t size)
+{
+    static const char* comparisons[] = {
+        ">", "<", ">=", "<=", "==", "!="
+    };
+
+    // (if (x > 1.234) {x * 5.678} {x - 9.012}) + ...
+    std::string result;
+
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        if (i > 0)
+        {
+            result += " + ";
+        }
+
+        result += "(if (x ";
+        result += comparisons[uniform(std::size(comparisons))];
+        result += ' ';
+        result += literal();
+        result += ") {x * ";
+        result += literal();
+        result += "} {x - ";
+        result += literal();
+        result += "})";
+    }
+
+    return result;
+}
+
+std::string ExpressionGenerator::longLiterals(std::size_t size)
+{
+    // 123456.789012345 * x + ...
+    std::string result;
+
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        if (i > 0)
+        {
+            result += " + ";
+        }
+
+        result += longLiteral();
+        result += " * x";
+    }
+
+    return result;
+}
+
+std::string ExpressionGenerator::literal()
+{
+    char buffer[32];
+
+    std::snprintf(
+        buffer,
+        sizeof(buffer),
+        "%zu.%03zu",
+        1 + uniform(9),
+        uniform(1000)
+    );
+
+    return buffer;
+}
+
+std::string ExpressionGenerator::longLiteral()
+{
+    char buffer[32];
+
+    std::snprintf(
+        buffer,
+        sizeof(buffer),
+        "%06zu.%09zu",
+        100000 + uniform(900000),
+        uniform(1000000000)
+    );
+
+    return buffer;
+}
+
+char ExpressionGenerator::binaryOperator()
+{
+    static const char operators[] = {'+', '-', '*', '/'};
+
+    return operators[uniform(std::size(operators))];
+}
+
+std::size_t ExpressionGenerator::uniform(std::size_t count)
+{
+    // Not using std::uniform_int_distribution, because
+    // it's implementation defined and breaks reproducibility.
+    return static_cast<std::size_t>(m_engine() % count);
+}
\ No newline at end of file
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/**
+ * @brief Structure, that describes generated
+ * expression.
+ */
+struct GeneratedExpression
+{
+    // Expression text.
+    std::string text;
+
+    // Names of used variables.
+    std::vector<std::string> variables;
+
+    // Is expression uses `if` and comparisons,
+    // that are not supported by tinyexpr.
+    bool usesLogic;
+};
+
+/**
+ * @brief Seeded generator of benchmark expressions.
+ * The same seed always produces the same expressions.
+ * Generated text is valid for both ExtCalculator
+ * and tinyexpr (except logic shape).
+ */
+class ExpressionGenerator
+{
+public:
+
+    /**
+     * @brief Expression shapes.
+     */
+    enum class Shape
+    {
+        DeepNesting,
+        WideSum,
+        ManyVariables,
+        FunctionHeavy,
+        LogicHeavy,
+        LongLiterals
+    };
+
+    /**
+     * @brief All shapes in declaration order.
+     */
+    static const std::vector<Shape> shapes;
+
+    /**
+     * @brief Constructor.
+     * @param seed Random engine seed.
+     */
+    explicit ExpressionGenerator(uint64_t seed);
+
+    /**
+     * @brief Method for generating expression.
+     * @param shape Expression shape.
+     * @param size Number of operations or terms.
+     * @return Generated expression.
+     */
+    GeneratedExpression generate(Shape shape, std::size_t size);
+
+    /**
+     * @brief Method for getting shape name.
+     */
+    static const char* shapeName(Shape shape);
+
+private:
+    std::string deepNesting(std::size_t size);
+
+    std::string wideSum(std::size_t size);
+
+    std::string manyVariables(std::size_t size, std::vector<std::string>& variables);
+
+    std::string functionHeavy(std::size_t size);
+
+    std::string logicHeavy(std::size_t size);
+
+    std::string longLiterals(std::size_t size);
+
+    // Literal in [1, 10) with 3 digits after dot.
+    std::string literal();
+
+    // Literal with 15 significant digits.
+    std::string longLiteral();
+
+    // One of `+`, `-`, `*`, `/`.
+    char binaryOperator();
+
+    std::size_t uniform(std::size_t count);
+
+    std::mt19937_64 m_engine;
+};
\ No newline at end of file
@@ -2,8 +2,42 @@
 #include <Calculator.hpp>
 #include <cmath>
 #include <sstream>
+#include <algorithm>
+#include <string_view>
 #include <tinyexpr.h>
 #include <gtest/gtest.h>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include "ExpressionGenerator.hpp"
+
+namespace
+{
+    // Number of heap allocations of the process.
+    std::atomic<std::size_t> allocationsCount(0);
+}
+
+void* operator new(std::size_t size)
+{
+    ++allocationsCount;
+
+    if (auto pointer = std::malloc(size ? size : 1))
+    {
+        return pointer;
+    }
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t /* size */) noexcept
+{
+    std::free(pointer);
+}
 
 static void libExecSpeed(benchmark::State& s)
 {
@@ -108,6 +142,146 @@ static void compilationOptimization(benchmark::State& s)
     s.SetComplexityN(s.range(0));
 }
 
+static void construction(benchmark::State& s)
+{
+    for (auto&& _ : s)
+    {
+        Calculator calculator;
+        calculator.addBasicFunctions();
+        calculator.addLogicFunctions();
+        calculator.addConstants();
+
+        benchmark::DoNotOptimize(calculator);
+    }
+}
+
+static void simulation(benchmark::State& s)
+{
+    Calculator calculator;
+    calculator.addBasicFunctions();
+    calculator.addLogicFunctions();
+    calculator.addRandomFunctions();
+
+    calculator.setExpression("if (exp(0.2 * normal()) > 1.1) {exp(0.2 * normal()) - 1.1} {0}");
+
+    for (auto&& _ : s)
+    {
+        benchmark::DoNotOptimize(calculator.simulate(1U << 20U, s.range(0)));
+    }
+}
+
+// Execution with variable changes, that must not
+// allocate memory after warm up.
+static void steadyState(benchmark::State& s)
+{
+    Calculator calculator;
+    calculator.addBasicFunctions();
+    calculator.addLogicFunctions();
+
+    calculator.setBackend(static_cast<Calculator::Backend>(s.range(0)));
+    calculator.setExpression("if (x > y) {sin(x) * y} {cos(y) / (x + 1)} + x^3");
+
+    auto x = calculator.variableHandle("x");
+    auto y = calculator.variableHandle("y");
+
+    calculator.setVariable(x, 1);
+    calculator.setVariable(y, 2);
+    calculator.execute();
+
+    auto allocations = allocationsCount.load();
+
+    double value = 0;
+
+    for (auto&& _ : s)
+    {
+        calculator.setVariable(x, value);
+        calculator.setVariable(y, value / 2);
+
+        value = calculator.execute() * 1e-3;
+
+        benchmark::DoNotOptimize(value);
+    }
+
+    auto count = allocationsCount.load() - allocations;
+
+    s.counters["allocations"] = static_cast<double>(count);
+
+    if (count != 0)
+    {
+        s.SkipWithError("Execution allocates memory");
+    }
+}
+
+static void gridExecute(benchmark::State& s)
+{
+    Calculator calculator;
+    calculator.addBasicFunctions();
+
+    calculator.setExpression("s * exp(0 - r * t) * log(s / 100) + sqrt(t) * sin(r * 10)");
+
+    for (auto&& _ : s)
+    {
+        for (int r = 0; r < 16; ++r)
+        {
+            calculator.setVariable("r", r * 0.01);
+
+            for (int spot = 0; spot < 64; ++spot)
+            {
+                calculator.setVariable("s", 50 + spot);
+
+                for (int t = 0; t < 1024; ++t)
+                {
+                    calculator.setVariable("t", t / 256.0);
+
+                    benchmark::DoNotOptimize(calculator.execute());
+                }
+            }
+        }
+    }
+}
+
+static void gridSweep(benchmark::State& s)
+{
+    Calculator calculator;
+    calculator.addBasicFunctions();
+
+    calculator.setExpression("s * exp(0 - r * t) * log(s / 100) + sqrt(t) * sin(r * 10)");
+
+    std::vector<double> rates(16);
+    std::vector<double> spots(64);
+    std::vector<double> times(1024);
+
+    for (std::size_t i = 0; i < rates.size(); ++i)
+    {
+        rates[i] = static_cast<double>(i) * 0.01;
+    }
+
+    for (std::size_t i = 0; i < spots.size(); ++i)
+    {
+        spots[i] = 50 + static_cast<double>(i);
+    }
+
+    for (std::size_t i = 0; i < times.size(); ++i)
+    {
+        times[i] = static_cast<double>(i) / 256.0;
+    }
+
+    std::vector<double> results(rates.size() * spots.size() * times.size());
+
+    for (auto&& _ : s)
+    {
+        calculator.sweep(
+            {
+                {"r", rates.data(), rates.size()},
+                {"s", spots.data(), spots.size()},
+                {"t", times.data(), times.size()}
+            },
+            results.data()
+        );
+
+        benchmark::DoNotOptimize(results.data());
+    }
+}
 
 BENCHMARK(libExecSpeed)
     ->Range(1, 1U << 20U)
@@ -129,4 +303,321 @@ BENCHMARK(compilationOptimization)
     ->Range(1, 1U << 20U)
     ->Complexity();
 
-BENCHMARK_MAIN();
\ No newline at end of file
+BENCHMARK(construction);
+
+BENCHMARK(simulation)
+    ->Arg(1)
+    ->Arg(4)
+    ->UseRealTime();
+
+BENCHMARK(steadyState)
+    ->Arg(static_cast<int>(Calculator::Backend::Stack))
+    ->Arg(static_cast<int>(Calculator::Backend::Register));
+
+BENCHMARK(gridExecute);
+
+BENCHMARK(gridSweep);
+
+namespace
+{
+    // Seed of expression generator. Can be changed
+    // with `--seed=<value>` argument.
+    const uint64_t DefaultSeed = 42;
+
+    // Number of operations in generated expressions.
+    const std::size_t ShapeSizes[] = {8, 64, 512};
+
+    // Value of every variable in generated expressions.
+    const double VariableValue = 0.5;
+
+    void setupCalculator(Calculator& calculator, const GeneratedExpression& expression)
+    {
+        calculator.addBasicFunctions();
+        calculator.addLogicFunctions();
+
+        for (auto&& variable : expression.variables)
+        {
+            calculator.setVariable(variable, VariableValue);
+        }
+    }
+
+    void shapeCompilation(benchmark::State& s, const GeneratedExpression& expression)
+    {
+        Calculator calculator;
+        setupCalculator(calculator, expression);
+
+        for (auto&& _ : s)
+        {
+            calculator.setExpression(expression.text);
+        }
+
+        s.SetBytesProcessed(
+            static_cast<int64_t>(s.iterations() * expression.text.size())
+        );
+
+        Calculator::CompileStatistics statistics;
+        calculator.setExpression(expression.text, true, &statistics);
+
+        s.counters["lexems"] = statistics.lexemsCount;
+        s.counters["rpn_length"] = statistics.rpnLength;
+        s.counters["optimized_length"] = statistics.optimizedLength;
+        s.counters["instructions"] = statistics.instructionsCount;
+        s.counters["folds"] = statistics.foldsCount;
+        s.counters["stack_depth"] = statistics.maxStackDepth;
+    }
+
+    void shapePhase(benchmark::State& s,
+                    const GeneratedExpression& expression,
+                    std::chrono::nanoseconds Calculator::CompileStatistics::* phase)
+    {
+        Calculator calculator;
+        setupCalculator(calculator, expression);
+
+        Calculator::CompileStatistics statistics;
+
+        for (auto&& _ : s)
+        {
+            calculator.setExpression(expression.text, true, &statistics);
+
+            s.SetIterationTime(
+                std::chrono::duration<double>(statistics.*phase).count()
+            );
+        }
+    }
+
+    void shapeExecution(benchmark::State& s,
+                        const GeneratedExpression& expression,
+                        Calculator::Backend backend)
+    {
+        Calculator calculator;
+        setupCalculator(calculator, expression);
+
+        calculator.setBackend(backend);
+
+        Calculator::CompileStatistics statistics;
+        calculator.setExpression(expression.text, true, &statistics);
+
+        for (auto&& _ : s)
+        {
+            auto result = calculator.execute();
+            benchmark::DoNotOptimize(result);
+        }
+
+        // Dispatches per execution without and
+        // with superinstructions.
+        s.counters["rpn_dispatches"] = statistics.optimizedLength;
+        s.counters["dispatches"] = statistics.instructionsCount;
+    }
+
+    /**
+     * @brief tinyexpr compiled expression with
+     * bound variables.
+     */
+    struct TinyexprExpression
+    {
+        explicit TinyexprExpression(const GeneratedExpression& expression) :
+            values(expression.variables.size(), VariableValue),
+            variables(),
+            compiled(nullptr)
+        {
+            for (std::size_t i = 0; i < expression.variables.size(); ++i)
+            {
+                te_variable variable = {};
+                variable.name = expression.variables[i].c_str();
+                variable.address = &values[i];
+
+                variables.push_back(variable);
+            }
+        }
+
+        ~TinyexprExpression()
+        {
+            te_free(compiled);
+        }
+
+        bool compile(const GeneratedExpression& expression)
+        {
+            te_free(compiled);
+
+            compiled = te_compile(
+                expression.text.c_str(),
+                variables.data(),
+                static_cast<int>(variables.size()),
+                nullptr
+            );
+
+            return compiled != nullptr;
+        }
+
+        std::vector<double> values;
+        std::vector<te_variable> variables;
+        te_expr* compiled;
+    };
+
+    void tinyexprShapeCompilation(benchmark::State& s, const GeneratedExpression& expression)
+    {
+        TinyexprExpression tinyexpr(expression);
+
+        for (auto&& _ : s)
+        {
+            if (!tinyexpr.compile(expression))
+            {
+                s.SkipWithError("tinyexpr can't compile expression");
+                break;
+            }
+        }
+
+        s.SetBytesProcessed(
+            static_cast<int64_t>(s.iterations() * expression.text.size())
+        );
+    }
+
+    void tinyexprShapeExecution(benchmark::State& s, const GeneratedExpression& expression)
+    {
+        TinyexprExpression tinyexpr(expression);
+
+        if (!tinyexpr.compile(expression))
+        {
+            s.SkipWithError("tinyexpr can't compile expression");
+            return;
+        }
+
+        for (auto&& _ : s)
+        {
+            auto result = te_eval(tinyexpr.compiled);
+            benchmark::DoNotOptimize(result);
+        }
+    }
+
+    void registerShapeSuite(uint64_t seed)
+    {
+        using Statistics = Calculator::CompileStatistics;
+
+        static const std::pair<const char*, std::chrono::nanoseconds Statistics::*> phases[] = {
+            {"splitOnLexems",       &Statistics::splittingTime},
+            {"pushLexems",          &Statistics::pushingTime},
+            {"performValidation",   &Statistics::validationTime},
+            {"performOptimization", &Statistics::optimizationTime},
+            {"buildProgram",        &Statistics::programTime}
+        };
+
+        ExpressionGenerator generator(seed);
+
+        for (auto shape : ExpressionGenerator::shapes)
+        {
+            for (auto size : ShapeSizes)
+            {
+                auto expression = generator.generate(shape, size);
+
+                auto suffix = std::string("/")
+                    .append(ExpressionGenerator::shapeName(shape))
+                    .append("/")
+                    .append(std::to_string(size));
+
+                benchmark::RegisterBenchmark(
+                    ("shapeCompilation" + suffix).c_str(),
+                    shapeCompilation,
+                    expression
+                );
+
+                for (auto&& phase : phases)
+                {
+                    benchmark::RegisterBenchmark(
+                        (std::string("shapePhase/") + phase.first + suffix).c_str(),
+                        shapePhase,
+                        expression,
+                        phase.second
+                    )->UseManualTime();
+                }
+
+                benchmark::RegisterBenchmark(
+                    ("shapeExecution" + suffix).c_str(),
+                    shapeExecution,
+                    expression,
+                    Calculator::Backend::Stack
+                );
+
+                benchmark::RegisterBenchmark(
+                    ("shapeRegisterExecution" + suffix).c_str(),
+                    shapeExecution,
+                    expression,
+                    Calculator::Backend::Register
+                );
+
+                if (expression.usesLogic)
+                {
+                    continue;
+                }
+
+                benchmark::RegisterBenchmark(
+                    ("tinyexprShapeCompilation" + suffix).c_str(),
+                    tinyexprShapeCompilation,
+                    expression
+                );
+
+                benchmark::RegisterBenchmark(
+                    ("tinyexprShapeExecution" + suffix).c_str(),
+                    tinyexprShapeExecution,
+                    expression
+                );
+            }
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<char*> arguments(argv, argv + argc);
+
+    // Own arguments
+    uint64_t seed = DefaultSeed;
+    std::string seedArgument = "--seed=";
+
+    for (auto iterator = arguments.begin(); iterator != arguments.end(); ++iterator)
+    {
+        if (std::string_view(*iterator).substr(0, seedArgument.size()) == seedArgument)
+        {
+            seed = std::stoull(*iterator + seedArgument.size());
+            arguments.erase(iterator);
+            break;
+        }
+    }
+
+    // Writing JSON results by default, so
+    // runs can be compared with each other.
+    std::string outputArgument = "--benchmark_out=ExtCalculatorBenchmark.json";
+    std::string formatArgument = "--benchmark_out_format=json";
+
+    auto hasOutput = std::any_of(
+        arguments.begin(),
+        arguments.end(),
+        [](const char* argument)
+        {
+            return std::string_view(argument).substr(0, 16) == "--benchmark_out=";
+        }
+    );
+
+    if (!hasOutput)
+    {
+        arguments.push_back(outputArgument.data());
+        arguments.push_back(formatArgument.data());
+    }
+
+    auto count = static_cast<int>(arguments.size());
+
+    benchmark::Initialize(&count, arguments.data());
+
+    if (benchmark::ReportUnrecognizedArguments(count, arguments.data()))
+    {
+        return 1;
+    }
+
+    benchmark::AddCustomContext("seed", std::to_string(seed));
+
+    registerShapeSuite(seed);
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+
+    return 0;
+}
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include <iostream>
+#include <utility>
 #include <ParsingException.hpp>
 #include <StatementException.hpp>
 #include <CalculationException.hpp>
@@ -157,6 +158,140 @@ std::string get_variable(const std::string& output)
     return std::string(start, static_cast<std::string::size_type>(size));
 }
 
+// Is string identifier, that can be surrounded
+// with spaces.
+bool is_identifier(const std::string& output)
+{
+    auto begin = output.find_first_not_of(' ');
+    auto end = output.find_last_not_of(' ');
+
+    if (begin == std::string::npos ||
+        getSymbolType(output[begin]) != SymbolType::Alphabetic)
+    {
+        return false;
+    }
+
+    for (auto i = begin; i <= end; ++i)
+    {
+        auto symbolType = getSymbolType(output[i]);
+
+        if (symbolType != SymbolType::Alphabetic &&
+            symbolType != SymbolType::Decimal &&
+            output[i] != '_')
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Is string function header `name(parameter, ...)`.
+bool is_definition(const std::string& output)
+{
+    auto openPos = output.find('(');
+    auto closePos = output.find(')');
+
+    if (openPos == std::string::npos ||
+        closePos == std::string::npos ||
+        closePos < openPos ||
+        output.find_first_not_of(' ', closePos + 1) != std::string::npos ||
+        !is_identifier(output.substr(0, openPos)))
+    {
+        return false;
+    }
+
+    auto list = output.substr(openPos + 1, closePos - openPos - 1);
+
+    // Function without parameters
+    if (list.find_first_not_of(' ') == std::string::npos)
+    {
+        return true;
+    }
+
+    std::string::size_type start = 0;
+
+    while (true)
+    {
+        auto commaPos = list.find(',', start);
+
+        if (!is_identifier(list.substr(start, commaPos - start)))
+        {
+            return false;
+        }
+
+        if (commaPos == std::string::npos)
+        {
+            return true;
+        }
+
+        start = commaPos + 1;
+    }
+}
+
+// Position of assignment. Equal signs of `==`,
+// `!=`, `<=` and `>=` operators are skipped.
+std::string::size_type find_assignment(const std::string& output)
+{
+    for (auto equalPos = output.find('=');
+         equalPos != std::string::npos;
+         equalPos = output.find('=', equalPos + 1))
+    {
+        if (equalPos + 1 < output.size() && output[equalPos + 1] == '=')
+        {
+            ++equalPos;
+            continue;
+        }
+
+        if (equalPos > 0 && std::string_view("<>!").find(output[equalPos - 1]) != std::string_view::npos)
+        {
+            continue;
+        }
+
+        return equalPos;
+    }
+
+    return std::string::npos;
+}
+
+std::string get_definition(const std::string& output, std::vector<std::string>& parameters)
+{
+    auto openPos = output.find('(');
+    auto closePos = output.find(')');
+
+    if (openPos == std::string::npos ||
+        closePos == std::string::npos ||
+        closePos < openPos ||
+        output.find_first_not_of(' ', closePos + 1) != std::string::npos)
+    {
+        throw ParsingException("Wrong function format");
+    }
+
+    auto list = output.substr(openPos + 1, closePos - openPos - 1);
+
+    // Function without parameters
+    if (list.find_first_not_of(' ') != std::string::npos)
+    {
+        std::string::size_type start = 0;
+
+        while (true)
+        {
+            auto commaPos = list.find(',', start);
+
+            parameters.push_back(get_variable(list.substr(start, commaPos - start)));
+
+            if (commaPos == std::string::npos)
+            {
+                break;
+            }
+
+            start = commaPos + 1;
+        }
+    }
+
+    return get_variable(output.substr(0, openPos));
+}
+
 int interactive(int, char**)
 {
     std::string output;
@@ -185,7 +320,20 @@ int interactive(int, char**)
         try
         {
             // Trying to split function and variable declaration
-            auto equalPos = output.find('=');
+            auto equalPos = find_assignment(output);
+            if (equalPos != std::string::npos &&
+                is_definition(output.substr(0, equalPos)))
+            {
+                std::vector<std::string> parameters;
+
+                auto functionName = get_definition(output.substr(0, equalPos), parameters);
+
+                calculator.defineFunction(functionName, parameters, output.substr(equalPos + 1));
+
+                std::cout << "Function \"" << functionName << "\" defined" << std::endl << std::endl;
+                continue;
+            }
+
             if (equalPos != std::string::npos)
             {
                 variableName = get_variable(output.substr(0, equalPos));
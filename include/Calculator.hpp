@@ -1,14 +1,26 @@
 #pragma once
 
+#include <array>
+#include <deque>
 #include <stack>
 #include <string>
+#include <string_view>
 #include <map>
 #include <variant>
 #include <vector>
 #include <functional>
+#include <chrono>
+#include <memory>
+#include <memory_resource>
+#include <iosfwd>
 #include "ParsingException.hpp"
 #include "StatementException.hpp"
 #include "CalculationException.hpp"
+#include "SerializationException.hpp"
+#include "SymbolTable.hpp"
+#include "CompileArena.hpp"
+#include "VectorMath.hpp"
+#include "ExpressionStore.hpp"
 
 /**
  * @brief Main calculator class.
@@ -31,12 +43,14 @@ public:
             Function,
             BraceOpen,
             BraceClosed,
-            Comma
+            Comma,
+            Reduction,
+            Parameter
         };
 
         using ValueType = std::variant<
-            Function*,   // Function
-            std::size_t, // Variable hash
+            const Function*, // Function
+            std::size_t, // Variable slot, reduction or parameter index
             NumberType   // Constant value
         >;
 
@@ -81,7 +95,7 @@ public:
             return *this;
         }
 
-        Lexem& operator=(Lexem& mv)
+        Lexem& operator=(const Lexem& mv)
         {
             type = mv.type;
             value = mv.value;
@@ -93,9 +107,20 @@ public:
         ValueType value;
     };
 
-    using LexemStack = std::deque<Lexem>;
+    using LexemStack = std::vector<Lexem>;
     using ArgumentsStack = std::vector<NumberType>;
 
+    /**
+     * @brief Batch function implementation. It computes
+     * `count` results from `count` values of every argument.
+     * Result array can be the same array as first argument.
+     * It should not throw, row errors are returned as NaN.
+     */
+    using BatchFunction = void (*)(const NumberType* const* arguments,
+                                   NumberType* result,
+                                   std::size_t count,
+                                   MathAccuracy accuracy);
+
     /**
      * @brief Structure, that describes
      * calculator function.
@@ -109,7 +134,11 @@ public:
             name(),
             numberOfArguments(0),
             priority(0),
-            function()
+            function(),
+            batch(),
+            contextFunction(),
+            context(),
+            body()
         {
 
         }
@@ -122,16 +151,69 @@ public:
          * validation.
          * @param priority Function priority.
          * @param function Pointer to function.
+         * @param batch Optional pointer to batch implementation.
+         * Functions without it are computed row by row
+         * in batch execution.
+         */
+        Function(std::string name,
+                 uint32_t numberOfArguments,
+                 std::size_t priority,
+                 NumberType (*function)(ArgumentsStack&),
+                 BatchFunction batch=nullptr
+        ) :
+            name(std::move(name)),
+            numberOfArguments(numberOfArguments),
+            priority(priority),
+            function(function),
+            batch(batch),
+            contextFunction(),
+            context(),
+            body()
+        {
+
+        }
+
+        /**
+         * @brief Constructor of function with context.
+         * @param name Function name.
+         * @param numberOfArguments Number of used arguments for
+         * validation.
+         * @param priority Function priority.
+         * @param function Pointer to function, that gets
+         * context with arguments.
+         * @param context User data, passed to function.
+         * It must live while function is registered.
          */
         Function(std::string name,
                  uint32_t numberOfArguments,
                  std::size_t priority,
-                 NumberType (*function)(ArgumentsStack&)
+                 NumberType (*function)(ArgumentsStack&, void*),
+                 void* context
         ) :
             name(std::move(name)),
             numberOfArguments(numberOfArguments),
             priority(priority),
-            function(function)
+            function(),
+            batch(),
+            contextFunction(function),
+            context(context),
+            body()
+        {
+
+        }
+
+        /**
+         * @brief Copy constructor.
+         */
+        Function(const Function& mv) :
+            name(mv.name),
+            numberOfArguments(mv.numberOfArguments),
+            priority(mv.priority),
+            function(mv.function),
+            batch(mv.batch),
+            contextFunction(mv.contextFunction),
+            context(mv.context),
+            body(mv.body)
         {
 
         }
@@ -143,7 +225,11 @@ public:
             name(std::move(mv.name)),
             numberOfArguments(mv.numberOfArguments),
             priority(mv.priority),
-            function(mv.function)
+            function(mv.function),
+            batch(mv.batch),
+            contextFunction(mv.contextFunction),
+            context(mv.context),
+            body(std::move(mv.body))
         {
 
         }
@@ -157,6 +243,10 @@ public:
             numberOfArguments = mv.numberOfArguments;
             priority = mv.priority;
             function = mv.function;
+            batch = mv.batch;
+            contextFunction = mv.contextFunction;
+            context = mv.context;
+            body = std::move(mv.body);
 
             return *this;
         }
@@ -171,10 +261,25 @@ public:
             numberOfArguments = mv.numberOfArguments;
             priority = mv.priority;
             function = mv.function;
+            batch = mv.batch;
+            contextFunction = mv.contextFunction;
+            context = mv.context;
+            body = mv.body;
 
             return (*this);
         }
 
+        /**
+         * @brief Method for calling implementation.
+         * Arguments are popped from stack.
+         */
+        NumberType call(ArgumentsStack& stack) const
+        {
+            return contextFunction ?
+                contextFunction(stack, context) :
+                function(stack);
+        }
+
         // Function name
         std::string name;
 
@@ -187,6 +292,333 @@ public:
 
         // Pointer to function implementation.
         NumberType (*function)(ArgumentsStack&);
+
+        // Pointer to batch implementation.
+        // Can be null.
+        BatchFunction batch;
+
+        // Pointer to implementation with context.
+        // It's used instead of `function` if set.
+        NumberType (*contextFunction)(ArgumentsStack&, void*);
+
+        // User data of implementation with context.
+        void* context;
+
+        // RPN of user-defined function, that is
+        // inlined at call sites. Empty for native
+        // functions.
+        LexemStack body;
+    };
+
+    /**
+     * @brief Column of variable values
+     * for batch execution.
+     */
+    struct BatchColumn
+    {
+        // Variable name.
+        std::string_view variable;
+
+        // Pointer to `rows` values.
+        const NumberType* values;
+    };
+
+    /**
+     * @brief Status of non throwing execution.
+     */
+    enum class ExecutionStatus
+    {
+        Success,
+
+        // Expression uses variable, that's not defined.
+        UndefinedVariable,
+
+        // There is no expression or it's not balanced.
+        UnbalancedExpression,
+
+        // Arrays in reduction have different sizes.
+        ArraySizeMismatch
+    };
+
+    /**
+     * @brief Result of non throwing execution.
+     */
+    struct ExecutionResult
+    {
+        ExecutionStatus status;
+
+        // NaN if execution failed.
+        NumberType value;
+    };
+
+    /**
+     * @brief Handle of variable for setting value
+     * without name lookup. It's valid for lifetime
+     * of calculator.
+     */
+    struct VariableHandle
+    {
+        std::size_t slot;
+    };
+
+    /**
+     * @brief Request of variable value from provider.
+     */
+    struct VariableRequest
+    {
+        // Variable name.
+        std::string_view name;
+
+        // Value, that's set by provider.
+        NumberType value;
+
+        // Is value set by provider.
+        bool found;
+    };
+
+    /**
+     * @brief Provider of variable values. It gets
+     * requests of all variables and context.
+     */
+    using VariableProvider = void (*)(VariableRequest* requests, std::size_t count, void* context);
+
+    /**
+     * @brief Values of variable in grid sweep.
+     */
+    struct SweepAxis
+    {
+        // Variable name.
+        std::string_view variable;
+
+        // Pointer to `count` values.
+        const NumberType* values;
+
+        std::size_t count;
+    };
+
+    /**
+     * @brief Summary statistics of Monte Carlo simulation.
+     */
+    struct SimulationResult
+    {
+        // Number of simulated paths.
+        std::size_t paths;
+
+        NumberType mean;
+
+        // Sample variance.
+        NumberType variance;
+
+        // Standard error of mean.
+        NumberType standardError;
+
+        NumberType min;
+        NumberType max;
+    };
+
+    /**
+     * @brief Root finding methods.
+     */
+    enum class SolverMethod
+    {
+        // Brent's method. Root has to be bracketed.
+        Brent,
+
+        // Newton's method. Derivative is computed along
+        // with expression, if all its functions have
+        // known derivatives, otherwise secant steps are used.
+        Newton
+    };
+
+    /**
+     * @brief Status of row root finding.
+     */
+    enum class SolverStatus : uint8_t
+    {
+        Converged,
+
+        // Expression has the same sign on bracket ends.
+        NoBracket,
+
+        // Root was not found in maximal number of iterations.
+        MaxIterations,
+
+        // Expression or its derivative is not finite or
+        // derivative is zero.
+        Failed
+    };
+
+    /**
+     * @brief Root finding parameters.
+     */
+    struct SolverOptions
+    {
+        SolverMethod method = SolverMethod::Brent;
+
+        // Bracket of Brent's method.
+        NumberType lower = 0;
+        NumberType upper = 1;
+
+        // Start point of Newton's method.
+        NumberType initial = 0;
+
+        // Absolute tolerance of root.
+        NumberType tolerance = 1e-12;
+
+        uint32_t maxIterations = 100;
+    };
+
+    /**
+     * @brief Numerical integration methods.
+     */
+    enum class QuadratureMethod
+    {
+        // Adaptive Gauss-Kronrod 7-15 rule. Intervals
+        // with the largest errors are bisected together.
+        GaussKronrod,
+
+        // Gauss-Legendre rule with fixed number of points.
+        GaussLegendre
+    };
+
+    /**
+     * @brief Numerical integration parameters.
+     */
+    struct QuadratureOptions
+    {
+        QuadratureMethod method = QuadratureMethod::GaussKronrod;
+
+        // Tolerances of adaptive method. Integration
+        // stops, when estimated error is less than one
+        // of them.
+        NumberType absoluteTolerance = 1e-10;
+        NumberType relativeTolerance = 1e-10;
+
+        // Maximal number of integrand evaluations
+        // of adaptive method.
+        uint32_t maxEvaluations = 15000;
+
+        // Number of points of Gauss-Legendre rule.
+        uint32_t points = 20;
+    };
+
+    /**
+     * @brief Expression execution backends.
+     */
+    enum class Backend
+    {
+        // Stack machine with superinstructions.
+        Stack,
+
+        // Register machine. Instructions read variables
+        // and constants in place and write temporary
+        // values into registers.
+        Register
+    };
+
+    /**
+     * @brief Structure, that describes
+     * expression compilation.
+     */
+    struct CompileStatistics
+    {
+        CompileStatistics() :
+            lexemsCount(0),
+            rpnLength(0),
+            optimizedLength(0),
+            instructionsCount(0),
+            foldsCount(0),
+            maxStackDepth(0),
+            startTime(),
+            splittingTime(0),
+            pushingTime(0),
+            validationTime(0),
+            optimizationTime(0),
+            programTime(0)
+        {
+
+        }
+
+        // Number of lexems in expression.
+        std::size_t lexemsCount;
+
+        // RPN length before optimization.
+        std::size_t rpnLength;
+
+        // RPN length after optimization.
+        std::size_t optimizedLength;
+
+        // Number of program instructions after
+        // superinstruction fusion.
+        std::size_t instructionsCount;
+
+        // Number of function calls, evaluated
+        // by constant folding.
+        std::size_t foldsCount;
+
+        // Maximal execution stack depth.
+        std::size_t maxStackDepth;
+
+        // Compilation start time.
+        std::chrono::steady_clock::time_point startTime;
+
+        // Time, spent in splitting on lexems.
+        std::chrono::nanoseconds splittingTime;
+
+        // Time, spent in converting to RPN.
+        std::chrono::nanoseconds pushingTime;
+
+        // Time, spent in validation.
+        std::chrono::nanoseconds validationTime;
+
+        // Time, spent in optimization.
+        std::chrono::nanoseconds optimizationTime;
+
+        // Time, spent in building program.
+        std::chrono::nanoseconds programTime;
+    };
+
+    /**
+     * @brief Structure with execution costs.
+     */
+    struct ProfileEntry
+    {
+        ProfileEntry() :
+            calls(0),
+            time(0)
+        {
+
+        }
+
+        // Number of calls.
+        uint64_t calls;
+
+        // Total execution time.
+        std::chrono::nanoseconds time;
+    };
+
+    /**
+     * @brief Structure with execution profile
+     * of current expression.
+     */
+    struct ExecutionProfile
+    {
+        ExecutionProfile() :
+            executions(0),
+            positions(),
+            functions()
+        {
+
+        }
+
+        // Number of profiled executions.
+        uint64_t executions;
+
+        // Costs of RPN positions.
+        std::vector<ProfileEntry> positions;
+
+        // Costs of functions by names.
+        std::map<std::string, ProfileEntry> functions;
     };
 
     /**
@@ -201,12 +633,31 @@ public:
      */
     Calculator();
 
+    Calculator(const Calculator&) = delete;
+    Calculator& operator=(const Calculator&) = delete;
+
     /**
      * @brief Method for setting exception
      * This method will perform lexical parsing.
+     * Temporary data is allocated from internal arena,
+     * so after warm up compilation does not allocate
+     * memory from global heap.
      * @param expression Expression.
+     * @param optimize Perform constant folding.
+     * @param statistics Optional pointer to structure,
+     * that will be filled with compilation statistics.
+     */
+    void setExpression(std::string_view expression,
+                       bool optimize=true,
+                       CompileStatistics* statistics=nullptr);
+
+    /**
+     * @brief Method for setting memory resource, that's
+     * used by compilation arena. Default resource is
+     * `std::pmr::get_default_resource()`.
+     * @param resource Memory resource.
      */
-    void setExpression(std::string expression, bool optimize=true);
+    void setMemoryResource(std::pmr::memory_resource* resource);
 
     /**
      * @brief Method for adding new function to
@@ -221,10 +672,149 @@ public:
     /**
      * @brief Method for executing expression.
      * Can throw CalculationException on any error.
+     * After first execution of expression it doesn't
+     * allocate memory, unless own functions do, or
+     * sizes of reduction arrays grow. Exceptions
+     * allocate messages, `tryExecute` doesn't.
      * @return Execution result.
      */
     NumberType execute();
 
+    /**
+     * @brief Method for executing expression without
+     * exceptions on undefined variables or unbalanced
+     * expression. Exceptions of user functions are
+     * not caught.
+     * @return Execution status and result.
+     */
+    ExecutionResult tryExecute();
+
+    /**
+     * @brief Method for executing expression over
+     * columns of variable values. Expression is computed
+     * in blocks of rows, so every function is called once
+     * per block. Built-in math functions use vectorized
+     * implementations with accuracy from `setMathAccuracy`.
+     * Variables without column use their current values.
+     * Can throw CalculationException if some variable
+     * is not defined.
+     * @param columns Variable columns.
+     * @param rows Number of rows.
+     * @param results Pointer to `rows` results.
+     */
+    void executeBatch(const std::vector<BatchColumn>& columns,
+                      std::size_t rows,
+                      NumberType* results);
+
+    /**
+     * @brief Method for executing expression over
+     * columns of variable values without exceptions.
+     * Rows, where some function throws `std::exception`
+     * or result is NaN, get NaN result and are marked
+     * in error bitmap, other rows are still computed.
+     * @param columns Variable columns.
+     * @param rows Number of rows.
+     * @param results Pointer to `rows` results.
+     * @param errors Pointer to `(rows + 63) / 64` words of
+     * error bitmap, row `i` is bit `i % 64` of word `i / 64`.
+     * @return Status of whole batch. Nothing is computed
+     * if it's not `ExecutionStatus::Success`.
+     */
+    ExecutionStatus tryExecuteBatch(const std::vector<BatchColumn>& columns,
+                                    std::size_t rows,
+                                    NumberType* results,
+                                    uint64_t* errors);
+
+    /**
+     * @brief Method for setting accuracy of built-in
+     * math functions in batch execution. Default accuracy
+     * is `MathAccuracy::CorrectlyRounded`.
+     * @param accuracy Accuracy tier.
+     */
+    void setMathAccuracy(MathAccuracy accuracy);
+
+    /**
+     * @brief Method for getting accuracy of built-in
+     * math functions in batch execution.
+     */
+    MathAccuracy getMathAccuracy() const;
+
+    /**
+     * @brief Method for setting execution backend.
+     * Current expression is recompiled for new backend.
+     * Default backend is `Backend::Stack`.
+     * @param backend Backend.
+     */
+    void setBackend(Backend backend);
+
+    /**
+     * @brief Method for getting execution backend.
+     */
+    Backend getBackend() const;
+
+    /**
+     * @brief Method for enabling execution profiling.
+     * Profiled execution records number of calls and
+     * time of every RPN position. Disabled profiling
+     * does not affect execution speed.
+     * Profile is reset on expression change.
+     * @param enabled Is profiling enabled.
+     */
+    void setProfiling(bool enabled);
+
+    /**
+     * @brief Method for resetting collected profile.
+     */
+    void resetProfile();
+
+    /**
+     * @brief Method for getting collected profile.
+     * @return Profile with costs of RPN positions
+     * and functions.
+     */
+    ExecutionProfile getProfile() const;
+
+    /**
+     * @brief Method for printing RPN, annotated
+     * with collected profile. Functions are listed
+     * in descending order of total time.
+     * @param stream Output stream.
+     */
+    void printProfile(std::ostream& stream) const;
+
+    /**
+     * @brief Method for solving `expression = target` for
+     * variable in every row of columns. Rows are solved in
+     * blocks, every row has own convergence, and converged
+     * rows are excluded from next iterations of block.
+     * Blocks are solved by several threads.
+     * Expression can't contain stateful functions.
+     * @param variable Unknown variable.
+     * @param columns Columns with values of other variables.
+     * Variables without columns use their values.
+     * @param rows Number of rows.
+     * @param targets Target values of rows. Zero is used,
+     * if it's `nullptr`.
+     * @param options Method and its parameters.
+     * @param roots Output array with `rows` roots. Rows,
+     * that are not converged, contain last approximation.
+     * @param iterations Optional output array with
+     * `rows` numbers of iterations.
+     * @param statuses Optional output array with
+     * `rows` statuses.
+     * @param threads Number of threads. Zero means
+     * number of hardware threads.
+     */
+    void solveBatch(std::string_view variable,
+                    const std::vector<BatchColumn>& columns,
+                    std::size_t rows,
+                    const NumberType* targets,
+                    const SolverOptions& options,
+                    NumberType* roots,
+                    uint32_t* iterations,
+                    SolverStatus* statuses,
+                    std::size_t threads=0);
+
     /**
      * @brief Method for adding basic functions.
      *
@@ -240,11 +830,14 @@ public:
      * `asin` - arc sine.
      * `atan` - arc tangent.
      * `atan2` - arc tangent with 2 params.
+     * `min` - minimum of 2 params.
+     * `max` - maximum of 2 params.
      * `cosh` - hyperbolic cosine.
      * `sinh` - hyperbolic sine.
      * `tanh` - hyperbolic tangent.
      * `log` - natural logarithm.
      * `log10` - common logarithm,
+     * `exp` - exponent.
      * `sqrt` - square root.
      * `ceil` - round up value.
      * `floor` - round down value.
@@ -269,78 +862,1037 @@ public:
     void addConstants();
 
     /**
-     * @brief Method for setting variable value.
-     * Variables can be changed after setting expression.
-     * @param name Variable name.
-     * @param value Variable value.
+     * @brief Method for adding array reductions.
+     * Arguments of reductions are computed element-wise
+     * over array variables, scalar values are broadcast.
+     * Arrays in one reduction must have equal sizes.
+     *
+     * Functions list:
+     * `sum` - sum of elements.
+     * `amin` - minimal element.
+     * `amax` - maximal element.
+     * `mean` - mean of elements.
+     * `dot` - dot product of two arrays.
      */
-    void setVariable(std::string name, NumberType value);
+    void addArrayFunctions();
 
     /**
-     * @brief Method for adding constant value.
-     * Constant values can not be changed after setting
-     * expression.
-     * @param name Constant name.
-     * @param value Constant variable.
+     * @brief Method for adding interpolation over tables.
+     * First argument is table name, second one is
+     * point. Points out of table are clamped.
+     *
+     * Functions list:
+     * `interp` - linear interpolation.
+     * `interp_step` - piecewise constant interpolation.
+     * `interp_cubic` - natural cubic spline.
      */
-    void addConstant(std::string name, NumberType value);
+    void addInterpolationFunctions();
 
     /**
-     * @brief Method for deleting variable name.
-     * std::invalid_argument exception will
-     * be thrown if there is no variable with this name.
-     * @param name Name.
+     * @brief Method for adding stateful functions for
+     * time series. Every call site of function in
+     * expression has own state, that's updated on
+     * every execution or batch row in O(1). State is
+     * reset on expression change.
+     *
+     * Functions list:
+     * `prev` - argument value of previous execution,
+     * NaN on first one.
+     * `ema` - exponential moving average, second argument
+     * is smoothing factor.
+     * `rolling_sum` - sum over window, second argument
+     * is constant window size.
+     * `rolling_mean` - mean over window, second argument
+     * is constant window size.
      */
-    void deleteVariable(const std::string& name);
+    void addStreamFunctions();
 
     /**
-     * @brief Method for getting parsed RPN.
-     * @param lexems Lexems.
+     * @brief Method for resetting state of stateful
+     * functions, for example before next series.
      */
-    void getRPN(LexemStack& lexems);
+    void resetStreams();
 
-private:
-    enum SymbolType
-    {
-        Alphabetic,
-        Special,
-        Decimal,
-        Braces,
-        Garbage
-    };
+    /**
+     * @brief Method for adding random variables. Every
+     * call site draws own sequence from counter-based
+     * Philox generator, n-th draw of call site depends
+     * only on seed, call site and n.
+     *
+     * Functions list:
+     * `uniform()` - uniform value in [0, 1).
+     * `normal()` - standard normal value.
+     */
+    void addRandomFunctions();
 
-    void splitOnLexems(std::string string, LexemStack& lexems);
+    /**
+     * @brief Method for setting seed of random variables.
+     * State of stateful functions is reset.
+     * @param seed Seed.
+     */
+    void setRandomSeed(uint64_t seed);
 
-    Calculator::SymbolType getSymbolType(char c);
+    /**
+     * @brief Method for Monte Carlo simulation of
+     * expression. Path `i` draws the same random values
+     * as `i`-th execution after seed setting. Paths are
+     * computed in blocks by several threads and results
+     * are combined in fixed order, so they are bitwise
+     * reproducible for any number of threads.
+     * Expression can't contain other stateful functions.
+     * @param paths Number of paths.
+     * @param threads Number of threads. Zero means
+     * number of hardware threads.
+     * @return Statistics of expression values.
+     */
+    SimulationResult simulate(std::size_t paths, std::size_t threads=0);
 
-    // Splitting on lexems states
-    void noneState  (char*& string, LexemStack& lexems, int& state);
-    void numberState(char*& string, LexemStack& lexems, int& state);
-    void stringState(char*& string, LexemStack& lexems, int& state);
-    void braceState (char*& string, LexemStack& lexems, int& state);
+    /**
+     * @brief Method for computing expression over
+     * Cartesian grid of variables. Axes are nested loops
+     * from outer to inner one. Every subexpression is
+     * computed at the outermost loop, that changes
+     * its variables, as batch over values of this loop,
+     * so inner loop computes only terms with its variable.
+     * Variables without axes use their values.
+     * Expression can't contain stateful functions.
+     * @param axes Swept variables from outer to inner.
+     * @param results Output array with product of axis
+     * sizes values. Inner axis index changes fastest.
+     */
+    void sweep(const std::vector<SweepAxis>& axes, NumberType* results);
+
+    /**
+     * @brief Method for adding numerical integration.
+     * `integrate(f, x, a, b)` is integral of `f` over
+     * variable `x` from `a` to `b`. Integrand is computed
+     * in vectorized blocks over all sample points of
+     * quadrature step. Integrals are computed once per
+     * execution like array reductions, so integrand and
+     * bounds can use only scalar variables, that are not
+     * integration variables of outer integrals.
+     *
+     * Functions list:
+     * `integrate` - definite integral.
+     */
+    void addIntegrationFunctions();
+
+    /**
+     * @brief Method for setting method and limits of
+     * numerical integration.
+     * @param options Quadrature parameters.
+     */
+    void setQuadrature(const QuadratureOptions& options);
+
+    /**
+     * @brief Method for adding lookup table. Table
+     * name is added as constant, that's used by
+     * interpolation functions. Tables on uniform
+     * grids are indexed without search.
+     * @param name Table name.
+     * @param x Points in increasing order.
+     * @param y Values in points.
+     */
+    void addTable(std::string_view name,
+                  std::vector<NumberType> x,
+                  std::vector<NumberType> y);
+
+    /**
+     * @brief Method for specializing expression with
+     * current values of variables. Variables are replaced
+     * with constants and expression is optimized again,
+     * so later changes of these variables are ignored
+     * until `generalize`. Specialization always starts
+     * from general expression. Reductions still read
+     * variables.
+     * @param variables Variable names.
+     */
+    void specialize(const std::vector<std::string_view>& variables);
+
+    /**
+     * @brief Method for restoring expression, that
+     * was set before specialization.
+     */
+    void generalize();
+
+    /**
+     * @brief Method for defining function in expression
+     * language. Body is inlined at every call site,
+     * so it's optimized with calling expression. Body
+     * can call previously defined functions.
+     * @param name Function name.
+     * @param parameters Parameter names. Parameters
+     * hide variables and constants with same names.
+     * @param body Function expression.
+     */
+    void defineFunction(std::string_view name,
+                        const std::vector<std::string>& parameters,
+                        std::string_view body);
+
+    /**
+     * @brief Method for setting variable value.
+     * Variables can be changed after setting expression.
+     * It allocates memory only, if variable is new.
+     * @param name Variable name.
+     * @param value Variable value.
+     */
+    void setVariable(std::string_view name, NumberType value);
+
+    /**
+     * @brief Method for getting variable handle. Variable
+     * is created undefined, if it doesn't exist.
+     * @param name Variable name.
+     * @return Variable handle.
+     */
+    VariableHandle variableHandle(std::string_view name);
+
+    /**
+     * @brief Method for setting variable value by
+     * handle. It never allocates memory.
+     * @param handle Variable handle.
+     * @param value Variable value.
+     */
+    void setVariable(VariableHandle handle, NumberType value);
+
+    /**
+     * @brief Method for binding variable to array.
+     * Arrays are used by reductions, outside of
+     * reductions array variable value is NaN.
+     * @param name Variable name.
+     * @param values Array values.
+     */
+    void setArray(std::string_view name, std::vector<NumberType> values);
+
+    /**
+     * @brief Method for adding constant value.
+     * Constant values can not be changed after setting
+     * expression.
+     * @param name Constant name.
+     * @param value Constant variable.
+     */
+    void addConstant(std::string_view name, NumberType value);
+
+    /**
+     * @brief Method for deleting variable name.
+     * std::invalid_argument exception will
+     * be thrown if there is no variable with this name.
+     * @param name Name.
+     */
+    void deleteVariable(std::string_view name);
+
+    /**
+     * @brief Method for getting variables, that are
+     * referenced by expression, in evaluation order.
+     * Variables of reductions are computed first.
+     * @return Variable names.
+     */
+    std::vector<std::string_view> referencedVariables() const;
+
+    /**
+     * @brief Method for setting provider of variable
+     * values. Provider is called once per execution,
+     * batch or simulation with requests of referenced
+     * variables without own values and columns, and
+     * provided values are used until next call.
+     * Requests are built without memory allocation.
+     * @param provider Provider or `nullptr`.
+     * @param context Provider context.
+     */
+    void setVariableProvider(VariableProvider provider, void* context);
+
+    /**
+     * @brief Method for freezing functions, constants
+     * and variables registries into perfect hashes.
+     * Should be called after setup, it speeds up
+     * name lookups in parsing. Adding new name
+     * unfreezes registry.
+     */
+    void freezeRegistry();
+
+    /**
+     * @brief Method for getting parsed RPN.
+     * @param lexems Lexems.
+     */
+    void getRPN(LexemStack& lexems);
+
+    /**
+     * @brief Method for saving compiled expression
+     * in binary form. Saved data contains RPN,
+     * constant pool, variable names and function
+     * names, so it can be loaded without parsing.
+     * Several expressions can be written into
+     * one stream sequentially. Expressions with
+     * reductions, integrals or table interpolation
+     * can't be saved, SerializationException
+     * will be thrown.
+     * @param stream Output binary stream.
+     */
+    void saveExpression(std::ostream& stream) const;
+
+    /**
+     * @brief Method for loading expression, that was
+     * saved with `saveExpression`. Functions are resolved
+     * by name in current calculator.
+     * SerializationException will be thrown if data was
+     * written by incompatible build, is damaged or
+     * references unknown function.
+     * @param stream Input binary stream.
+     */
+    void loadExpression(std::istream& stream);
+
+    /**
+     * @brief Method for writing expressions store, that's
+     * opened with ExpressionStore. Expressions are compiled
+     * and optimized by this calculator, so its functions
+     * and constants are used. Calculator is left with
+     * last expression.
+     * @param stream Output binary stream.
+     * @param expressions Expressions. Index of expression
+     * in store is its index in this list.
+     */
+    void saveStore(std::ostream& stream, const std::vector<std::string_view>& expressions);
+
+    /**
+     * @brief Method for binding expressions store. Functions
+     * of store are resolved by name in current calculator,
+     * variables of store are variables of calculator.
+     * Store is not copied, so it must outlive binding.
+     * SerializationException will be thrown if store
+     * references unknown function.
+     * @param store Expressions store.
+     */
+    void bindStore(const ExpressionStore& store);
+
+    /**
+     * @brief Method for executing expression from bound
+     * store. Program is read from store directly, current
+     * expression is not changed.
+     * @param index Expression index.
+     * @return Result.
+     */
+    NumberType executeStored(std::size_t index);
+
+private:
+
+    /**
+     * @brief Variable slot value.
+     */
+    struct Variable
+    {
+        Variable() :
+            value(0),
+            defined(false),
+            provided(false),
+            array(false),
+            elements()
+        {
+
+        }
+
+        NumberType value;
+
+        // Is value was set.
+        bool defined;
+
+        // Is value set by provider for
+        // current execution.
+        bool provided;
+
+        // Is variable bound to array.
+        bool array;
+
+        // Array values.
+        std::vector<NumberType> elements;
+    };
+
+    using FunctionTable = SymbolTable<Function>;
+
+    /**
+     * @brief Sets of built-in functions.
+     */
+    enum FunctionSet : unsigned
+    {
+        BasicFunctionSet = 1U,
+        LogicFunctionSet = 2U,
+        ArrayFunctionSet = 4U,
+
+        // Every combination of sets
+        FunctionSetsCount = 8U
+    };
+
+    /**
+     * @brief Lookup table for interpolation.
+     */
+    struct Table
+    {
+        // Points in increasing order.
+        std::vector<NumberType> x;
+
+        // Values in points.
+        std::vector<NumberType> y;
+
+        // Second derivatives of cubic spline.
+        std::vector<NumberType> curvatures;
+
+        // Distance between points of uniform
+        // grid. Zero for other grids.
+        NumberType step;
+    };
+
+    /**
+     * @brief Polynomial in one variable, detected
+     * in expression. Polynomial lexem is function
+     * lexem with polynomial as context.
+     */
+    struct Polynomial
+    {
+        // Maximal degree of detected polynomials.
+        static constexpr std::size_t MaxDegree = 16;
+
+        Polynomial() :
+            function(),
+            coefficients(),
+            count(0)
+        {
+
+        }
+
+        Function function;
+
+        // Coefficients from constant term. They are
+        // stored inline, so compilation does not
+        // allocate memory for them.
+        std::array<NumberType, MaxDegree + 1> coefficients;
+
+        // Number of coefficients.
+        std::size_t count;
+    };
+
+    /**
+     * @brief State of stateful function call site.
+     * Call site lexem is function lexem with stream
+     * as context.
+     */
+    struct Stream
+    {
+        Function function;
+
+        // Previous value or moving average.
+        NumberType value;
+
+        // Number of processed values.
+        std::size_t count;
+
+        // Ring of window values and position
+        // of oldest one.
+        std::vector<NumberType> window;
+        std::size_t position;
+
+        // Sum of window values.
+        NumberType sum;
+
+        // Random generator key and index of
+        // call site among random call sites.
+        uint64_t seed;
+        uint32_t site;
+    };
+
+    /**
+     * @brief Buffers of block computation.
+     */
+    struct BatchWorkspace
+    {
+        BatchWorkspace() :
+            stack(),
+            arguments(),
+            values(),
+            derivatives()
+        {
+
+        }
+
+        // Stack of value blocks.
+        std::vector<NumberType> stack;
+
+        // Function arguments pointers.
+        std::vector<const NumberType*> arguments;
+
+        // Arguments of row by row calls.
+        ArgumentsStack values;
+
+        // Stack of derivative blocks. Used, if
+        // derivative is computed.
+        std::vector<NumberType> derivatives;
+    };
+
+    /**
+     * @brief Derivatives of built-in functions.
+     */
+    enum class DerivativeRule
+    {
+        None,
+        Add,
+        Subtract,
+        Multiply,
+        Divide,
+        Power,
+        Polynomial,
+        Abs,
+        Sin,
+        Cos,
+        Tan,
+        Asin,
+        Acos,
+        Sinh,
+        Cosh,
+        Tanh,
+        Exp,
+        Log,
+        Log10,
+        Sqrt,
+
+        // Piecewise constant functions.
+        Step,
+
+        // `if` function.
+        Select
+    };
+
+    /**
+     * @brief Buffers of block solving.
+     */
+    struct SolverWorkspace
+    {
+        SolverWorkspace() :
+            batch(),
+            active(),
+            columns(),
+            gathered(),
+            points(),
+            state(),
+            finished()
+        {
+
+        }
+
+        BatchWorkspace batch;
+
+        // Rows of block, that are not converged.
+        std::vector<uint32_t> active;
+
+        // Columns by variable slots.
+        std::vector<const NumberType*> columns;
+
+        // Column values of active rows.
+        std::vector<NumberType> gathered;
+
+        // Points of active rows.
+        std::vector<NumberType> points;
+
+        // Method state of rows.
+        std::vector<NumberType> state;
+
+        // Are rows solved.
+        std::vector<uint8_t> finished;
+    };
+
+    /**
+     * @brief Array reduction types.
+     */
+    enum class ReductionType
+    {
+        None,
+        Sum,
+        Min,
+        Max,
+        Mean,
+        Dot,
+        Integral
+    };
+
+    /**
+     * @brief Array reduction, extracted from expression.
+     * Reduction lexems contain index of reduction.
+     */
+    struct Reduction
+    {
+        ReductionType type;
+
+        const Function* function;
+
+        // Arguments RPN, computed element-wise.
+        std::vector<LexemStack> arguments;
+
+        // Variable slots, used by arguments.
+        std::vector<std::size_t> variables;
+
+        // Integration variable slot of integral.
+        std::size_t variable;
+
+        // Result of last computation.
+        NumberType value;
+    };
+
+    /**
+     * @brief Subexpression of grid sweep, that's computed
+     * at loop level of its innermost variable. Constants
+     * in arguments positions are replaced with values of
+     * outer terms before computation.
+     */
+    struct SweepTerm
+    {
+        explicit SweepTerm(std::size_t termLevel) :
+            expression(),
+            arguments(),
+            level(termLevel),
+            values()
+        {
+
+        }
+
+        LexemStack expression;
+
+        // Positions of outer term values and term indices.
+        std::vector<std::pair<std::size_t, std::size_t>> arguments;
+
+        // Loop level. Zero level is computed once.
+        std::size_t level;
+
+        // Values for all values of loop variable.
+        std::vector<NumberType> values;
+    };
+
+    /**
+     * @brief Interval of adaptive integration.
+     */
+    struct QuadratureInterval
+    {
+        NumberType lower;
+        NumberType upper;
+
+        // Kronrod estimate of integral.
+        NumberType integral;
+
+        // Estimated error of integral.
+        NumberType error;
+    };
+
+    /**
+     * @brief Built-in arithmetic operation, that's
+     * computed inside execution loop.
+     */
+    enum class Operation : uint8_t
+    {
+        None,
+        Add,
+        Subtract,
+        Multiply,
+        Divide,
+        Power
+    };
+
+    /**
+     * @brief Program instruction. Superinstructions
+     * take operands inline, operands point to variable
+     * values or program constants.
+     */
+    struct Instruction
+    {
+        // Codes of every operation group
+        // go in `Operation` order.
+        enum class Code : uint8_t
+        {
+            Push,     // Push operand
+            Call,     // Call function
+            PushCall, // Push operand, call function
+
+            // Operation on two values at stack top
+            Add,
+            Subtract,
+            Multiply,
+            Divide,
+            Power,
+
+            // Operation on stack top and operand
+            PushAdd,
+            PushSubtract,
+            PushMultiply,
+            PushDivide,
+            PushPower,
+
+            // Operation on two operands
+            PushPushAdd,
+            PushPushSubtract,
+            PushPushMultiply,
+            PushPushDivide,
+            PushPushPower,
+
+            Return    // End of program
+        };
+
+        Code code;
+        const NumberType* operands[2];
+        const Function* function;
+
+        // Address of instruction handler. Used
+        // by direct threaded execution.
+        const void* handler;
+    };
+
+    /**
+     * @brief Register machine instruction. Sources
+     * point to variable values, program constants
+     * or registers.
+     */
+    struct RegisterInstruction
+    {
+        // Built-in operation or `Operation::None`
+        // for function call.
+        Operation operation;
+
+        const Function* function;
+
+        // Sources in order of function arguments.
+        const NumberType* const* sources;
+
+        NumberType* destination;
+    };
+
+    enum SymbolType
+    {
+        Alphabetic,
+        Special,
+        Decimal,
+        Braces,
+        Garbage
+    };
+
+    // Temporary lexems container, allocated
+    // from compilation arena.
+    using LexemBuffer = std::pmr::vector<Lexem>;
+
+    void splitOnLexems(std::string_view string, LexemBuffer& lexems);
+
+    Calculator::SymbolType getSymbolType(char c);
+
+    // Splitting on lexems states
+    void noneState  (const char*& string, LexemBuffer& lexems, int& state);
+    void numberState(const char*& string, LexemBuffer& lexems, int& state);
+    void stringState(const char*& string, LexemBuffer& lexems, int& state);
+    void braceState (const char*& string, LexemBuffer& lexems, int& state);
 
     // Validating pushed values
     void performValidation();
 
     // Pushing lexems as RPN
-    void pushLexems(LexemStack& lexems);
+    void pushLexems(LexemBuffer& lexems);
+
+    // Optimization. Returns number of folded functions.
+    std::size_t performOptimization();
+
+    // Replacing polynomials in one variable with
+    // polynomial lexems. Returns number of polynomials.
+    std::size_t detectPolynomials();
+
+    // Evaluation of polynomial in context. Short
+    // polynomials use Horner's scheme, long ones
+    // use Estrin's scheme.
+    static NumberType evaluatePolynomial(ArgumentsStack& stack, void* context);
 
-    // Optimization
-    void performOptimization();
+    // Replacing stateful functions with call
+    // sites, that have own states.
+    void instantiateStreams();
 
-    // Functions by hashes.
-    std::map<std::size_t, Function> m_functions;
+    // Is function stateful and needs call site
+    static bool isStream(const Function* function);
 
-    // Variable values by hashes.
-    std::map<std::size_t, NumberType> m_variables;
+    // Is function random variable
+    static bool isRandom(const Function* function);
 
-    // Constant values by hashes.
-    std::map<std::size_t, NumberType> m_constants;
+    // Implementations of random variables
+    static NumberType randomUniform(ArgumentsStack& stack, void* context);
+    static NumberType randomNormal(ArgumentsStack& stack, void* context);
+
+    // Implementations of stateful functions
+    static NumberType streamPrev(ArgumentsStack& stack, void* context);
+    static NumberType streamEma(ArgumentsStack& stack, void* context);
+    static NumberType streamRollingSum(ArgumentsStack& stack, void* context);
+    static NumberType streamRollingMean(ArgumentsStack& stack, void* context);
+
+    // Maximal execution stack depth of expression
+    std::size_t stackDepth(const LexemStack& expression) const;
+
+    // Replacing calls of user-defined functions
+    // with their bodies.
+    void inlineFunctions();
+
+    // Start of value, that is computed by RPN
+    // lexems before `end`.
+    static std::size_t argumentStart(const LexemStack& expression, std::size_t end);
+
+    // Implementation of user-defined functions.
+    // It's never called, because calls are inlined.
+    static NumberType inlinedFunction(ArgumentsStack& stack);
+
+    // Moving reduction arguments from expression
+    // into reductions.
+    void extractReductions();
+
+    // Computing reductions. Returns false if
+    // arrays have different sizes.
+    bool computeReductions();
+
+    // Built-in reduction, performed by function
+    static ReductionType getReduction(const Function* function);
+
+    // Scalar implementations of reductions
+    static NumberType arraySum(ArgumentsStack& stack);
+    static NumberType arrayMin(ArgumentsStack& stack);
+    static NumberType arrayMax(ArgumentsStack& stack);
+    static NumberType arrayMean(ArgumentsStack& stack);
+    static NumberType arrayDot(ArgumentsStack& stack);
+
+    // Integral implementation. It's never called,
+    // because integrals are reductions.
+    static NumberType integrate(ArgumentsStack& stack);
+
+    // Splitting expression into sweep terms by loop
+    // levels of variable slots. Terms are ordered from
+    // arguments to expression, so expression is last.
+    void buildSweepTerms(const std::vector<std::size_t>& levels, std::vector<SweepTerm>& terms) const;
+
+    // Checking integration variable and removing
+    // it from variables of integral.
+    void extractIntegral(Reduction& reduction) const;
+
+    // Computing integral of reduction.
+    NumberType computeIntegral(Reduction& reduction);
+
+    // Computing integrand in points of quadrature.
+    void computeIntegrand(const Reduction& reduction);
+
+    // Process-wide registry with operators and built-in
+    // function sets. It's built once and never changed.
+    static std::shared_ptr<const FunctionTable> sharedFunctions(unsigned sets);
+
+    // Process-wide registry with default constants
+    static std::shared_ptr<const SymbolTable<NumberType>> sharedConstants();
+
+    // Adding built-in function sets. Shared registry
+    // is used, if there are no own functions.
+    void addFunctionSets(unsigned sets);
+
+    // Moving compiled expression from function
+    // to function with the same name.
+    void rebindFunction(const Function* from, const Function* to);
+
+    // Filling registries with built-in functions
+    static void insertFunction(FunctionTable& functions, Function function);
+    static void fillFunctionSets(FunctionTable& functions, unsigned sets);
+    static void fillOperators(FunctionTable& functions);
+    static void fillBasicFunctions(FunctionTable& functions);
+    static void fillLogicFunctions(FunctionTable& functions);
+    static void fillArrayFunctions(FunctionTable& functions);
+
+    // Table, that's referenced by first argument.
+    // Arguments are popped from stack.
+    static const Table& popTable(ArgumentsStack& stack, void* context, NumberType& point);
+
+    // Index of table segment, that contains point.
+    // Points out of table are in edge segments.
+    static std::size_t findSegment(const Table& table, NumberType point);
+
+    // Implementations of interpolation
+    static NumberType interpolateLinear(ArgumentsStack& stack, void* context);
+    static NumberType interpolateStep(ArgumentsStack& stack, void* context);
+    static NumberType interpolateCubic(ArgumentsStack& stack, void* context);
+
+    // Computing expression for block of rows. Result is
+    // placed at start of batch stack. Returns stack depth.
+    std::size_t computeBlock(const LexemStack& expression,
+                             const NumberType* const* columns,
+                             std::size_t offset,
+                             std::size_t count,
+                             uint64_t* errors);
+
+    // Computing block with own workspace, so blocks of
+    // expression without stateful functions can be
+    // computed by several threads. Derivatives by
+    // variable are computed into workspace, if slot
+    // is passed.
+    std::size_t computeBlock(const LexemStack& expression,
+                             const NumberType* const* columns,
+                             std::size_t offset,
+                             std::size_t count,
+                             uint64_t* errors,
+                             BatchWorkspace& workspace,
+                             std::size_t derivativeSlot=SymbolTable<Variable>::npos) const;
+
+    // Derivative rule of function or `None`
+    static DerivativeRule getDerivativeRule(const Function* function);
+
+    // Computing derivative of function by chain rule.
+    // Result replaces derivative of first argument.
+    static void differentiate(const Function* function,
+                              const NumberType* values,
+                              NumberType* derivatives,
+                              std::size_t count);
+
+    // Solving rows of one block
+    void solveBlock(const LexemStack& expression,
+                    std::size_t slot,
+                    bool differentiable,
+                    const std::vector<std::pair<std::size_t, const NumberType*>>& columns,
+                    std::size_t begin,
+                    std::size_t count,
+                    const NumberType* targets,
+                    const SolverOptions& options,
+                    NumberType* roots,
+                    uint32_t* iterations,
+                    SolverStatus* statuses,
+                    SolverWorkspace& workspace) const;
+
+    // Computing function over block of arguments.
+    // Result replaces first argument.
+    void computeFunction(const Function* function,
+                         NumberType* block,
+                         std::size_t offset,
+                         std::size_t count,
+                         uint64_t* errors,
+                         BatchWorkspace& workspace) const;
+
+    // Running worker on several threads, but not more
+    // than tasks. Worker takes tasks itself. First
+    // exception is rethrown, when all workers are finished.
+    static void runParallel(std::size_t threads,
+                            std::size_t tasks,
+                            const std::function<void()>& worker);
+
+    // Checking variables and computing reductions
+    // before execution.
+    ExecutionStatus prepareExecution(std::size_t& undefinedSlot);
+
+    // Lexem type and pool index pairs of saved program
+    using SavedProgram = std::vector<std::pair<uint8_t, uint32_t>>;
+
+    // Encoding expression as program over pools of
+    // constants, variable slots and functions.
+    void encodeExpression(std::vector<NumberType>& constants,
+                          std::vector<std::size_t>& variables,
+                          std::vector<const Function*>& functions,
+                          SavedProgram& program) const;
+
+    // Removing compiled expression with its program,
+    // so calculator has no expression.
+    void clearExpression();
+
+    // Building program for current backend from RPN
+    void buildProgram();
+    void buildStackProgram();
+    void buildRegisterProgram();
+
+    // Requesting values of variables of slots without
+    // own values and columns from provider.
+    void provideVariables(const std::vector<std::size_t>& slots, const NumberType* const* columns);
+
+    // Slot of first undefined variable, that's
+    // used by expression, or `npos`.
+    std::size_t undefinedVariable() const;
+
+    // Execution of program
+    NumberType executeProgram();
+    NumberType executeStackProgram();
+    NumberType executeRegisterProgram();
+
+    // Pointer to variable value or program constant
+    const NumberType* programValue(const Lexem& lexem);
+
+    // Built-in operation
+    static NumberType operate(Operation operation, NumberType lhs, NumberType rhs);
+
+    // Built-in operation, performed by function
+    static Operation getOperation(const Function* function);
+
+    // Built-in operators
+    static NumberType add(ArgumentsStack& stack);
+    static NumberType subtract(ArgumentsStack& stack);
+    static NumberType multiply(ArgumentsStack& stack);
+    static NumberType divide(ArgumentsStack& stack);
+    static NumberType power(ArgumentsStack& stack);
+
+    // Batch execution. Rows errors are collected
+    // into bitmap, if it's passed.
+    ExecutionStatus computeBatch(const std::vector<BatchColumn>& columns,
+                                 std::size_t rows,
+                                 NumberType* results,
+                                 uint64_t* errors,
+                                 std::size_t& undefinedSlot);
+
+    // Execution with optional profiling
+    template<bool Profile>
+    NumberType executeExpression();
+
+    // Functions by names. Built-in functions are
+    // in shared base table.
+    FunctionTable m_functions;
+
+    // Built-in sets in shared base of functions.
+    unsigned m_functionSets;
+
+    // Variable slots by names. Variable lexems
+    // contain slot index.
+    SymbolTable<Variable> m_variables;
+
+    // Constant values by names.
+    SymbolTable<NumberType> m_constants;
+
+    // Lookup tables by names. Table constants
+    // contain table index.
+    SymbolTable<Table> m_tables;
 
     // Container with parsed expression in revese
     // polish notation.
     LexemStack m_expression;
 
+    // Execution backend.
+    Backend m_backend;
+
+    // Stack machine program, that's built from RPN.
+    std::vector<Instruction> m_program;
+
+    // Are instruction handlers resolved.
+    bool m_programThreaded;
+
+    // Register machine program, that's built from RPN.
+    std::vector<RegisterInstruction> m_registerProgram;
+
+    // Sources of register machine instructions.
+    std::vector<const NumberType*> m_registerSources;
+
+    // Registers for temporary values.
+    std::vector<NumberType> m_registers;
+
+    // Pointer to result of register machine program.
+    const NumberType* m_registerResult;
+
+    // Constants, referenced by program.
+    std::vector<NumberType> m_programConstants;
+
+    // Variable slots, referenced by program.
+    std::vector<std::size_t> m_programVariables;
+
+    // Variable slots, referenced by expression, in
+    // evaluation order.
+    std::vector<std::size_t> m_referencedVariables;
+
+    // Provider of variable values and its context.
+    VariableProvider m_variableProvider;
+    void* m_providerContext;
+
+    // Requests to provider and their slots.
+    std::vector<VariableRequest> m_variableRequests;
+    std::vector<std::size_t> m_requestedSlots;
+
     // Internal brace counter, that's used in
     // lexem states.
     int m_braceTest;
@@ -348,8 +1900,83 @@ private:
     // Arguments stack buffer. Used in execution.
     ArgumentsStack m_executionStack;
 
-    // Hash calculator for strings.
-    std::hash<std::string_view> m_stringHash;
+    // Is execution profiled.
+    bool m_profiling;
+
+    // Costs of RPN positions. Empty if
+    // profiling is disabled.
+    std::vector<ProfileEntry> m_profile;
+
+    // Number of profiled executions.
+    uint64_t m_profiledExecutions;
+
+    // Memory for temporary compilation data.
+    // Reset on every compilation.
+    CompileArena m_compileArena;
+
+    // Accuracy of math functions in batch execution.
+    MathAccuracy m_mathAccuracy;
+
+    // Buffers of batch execution.
+    BatchWorkspace m_batchWorkspace;
+
+    // Parameter names of function, that's being
+    // defined. Used in parsing.
+    const std::vector<std::string>* m_parameters;
+
+    // Polynomials of expression. Deque keeps
+    // contexts of polynomial functions stable.
+    std::deque<Polynomial> m_polynomials;
+
+    // States of stateful function call sites.
+    // Deque keeps contexts stable.
+    std::deque<Stream> m_streams;
+
+    // Seed of random variables.
+    uint64_t m_randomSeed;
+
+    // Expression before specialization. It's
+    // empty, if expression is not specialized.
+    LexemStack m_generalExpression;
+
+    // Number of polynomials of general expression.
+    std::size_t m_generalPolynomials;
+
+    // Array reductions of expression.
+    std::vector<Reduction> m_reductions;
+
+    // Array columns by variable slots. Used in reductions.
+    std::vector<const NumberType*> m_reductionColumns;
+
+    // First argument block of two argument reductions.
+    std::vector<NumberType> m_reductionBuffer;
+
+    // Numerical integration parameters.
+    QuadratureOptions m_quadrature;
+
+    // Nodes and weights of Gauss-Legendre rule on [-1, 1].
+    std::vector<NumberType> m_legendreNodes;
+    std::vector<NumberType> m_legendreWeights;
+
+    // Intervals of adaptive integration.
+    std::vector<QuadratureInterval> m_quadratureIntervals;
+
+    // Sample points of quadrature step and
+    // integrand values in them.
+    std::vector<NumberType> m_quadraturePoints;
+    std::vector<NumberType> m_quadratureValues;
+
+    // Bound expressions store.
+    const ExpressionStore* m_store;
+
+    // Functions of bound store.
+    std::vector<const Function*> m_storeFunctions;
+
+    // Variable slots of bound store.
+    std::vector<std::size_t> m_storeVariables;
+
+    // Variable slots of stored expressions.
+    std::vector<std::vector<std::size_t>> m_storeReferences;
 };
 
 std::ostream& operator<<(std::ostream& stream, const Calculator::LexemStack& stack);
\ No newline at end of file
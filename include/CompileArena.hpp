@@ -0,0 +1,97 @@
+#pragma once
+
+#include <memory_resource>
+#include <vector>
+#include <cstddef>
+
+/**
+ * @brief Monotonic memory resource, that's used
+ * for temporary containers of expression compilation.
+ * Memory is never freed until `reset`, that rewinds
+ * arena for next compilation. If previous compilation
+ * did not fit into one block, blocks are merged on
+ * reset, so after warm up compilation of expressions
+ * with similar sizes does not touch upstream resource.
+ */
+class CompileArena : public std::pmr::memory_resource
+{
+public:
+
+    /**
+     * @brief Constructor.
+     * @param upstream Resource, that's used for
+     * arena blocks allocation.
+     */
+    explicit CompileArena(
+        std::pmr::memory_resource* upstream=std::pmr::get_default_resource()
+    );
+
+    /**
+     * @brief Copy constructor. Memory is not
+     * copied, new arena uses the same upstream.
+     */
+    CompileArena(const CompileArena& rhs);
+
+    /**
+     * @brief Destructor.
+     */
+    ~CompileArena() override;
+
+    /**
+     * @brief Copy operator. Memory is not
+     * copied, arena starts to use upstream of `rhs`.
+     */
+    CompileArena& operator=(const CompileArena& rhs);
+
+    /**
+     * @brief Method for rewinding arena. All
+     * memory, allocated from arena, becomes invalid.
+     */
+    void reset();
+
+    /**
+     * @brief Method for setting upstream resource.
+     * All arena blocks are released.
+     * @param upstream Upstream resource.
+     */
+    void setUpstream(std::pmr::memory_resource* upstream);
+
+    /**
+     * @brief Method for getting upstream resource.
+     */
+    std::pmr::memory_resource* upstream() const;
+
+    /**
+     * @brief Method for getting total size of
+     * arena blocks.
+     */
+    std::size_t capacity() const;
+
+protected:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+
+    void do_deallocate(void* pointer, std::size_t bytes, std::size_t alignment) override;
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+private:
+    struct Block
+    {
+        std::byte* data;
+        std::size_t size;
+    };
+
+    void release();
+
+    // Resource for blocks allocation.
+    std::pmr::memory_resource* m_upstream;
+
+    // Allocated blocks.
+    std::vector<Block> m_blocks;
+
+    // Index of current block.
+    std::size_t m_currentBlock;
+
+    // Used bytes in current block.
+    std::size_t m_offset;
+};
\ No newline at end of file
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <iosfwd>
+#include "Calculator.hpp"
+
+/**
+ * @brief Collector of compilation statistics, that
+ * writes them in Chrome trace event format. Result
+ * can be opened in `chrome://tracing` or Perfetto.
+ * Every compilation is shown as event with nested
+ * phase events. Counters are placed into event
+ * arguments.
+ */
+class CompileTrace
+{
+public:
+
+    /**
+     * @brief Constructor.
+     */
+    CompileTrace();
+
+    /**
+     * @brief Method for adding compilation.
+     * @param name Compilation name, for example
+     * expression or tenant identifier.
+     * @param statistics Compilation statistics.
+     * @param thread Thread identifier, that's used
+     * for grouping compilations.
+     */
+    void addCompilation(std::string_view name,
+                        const Calculator::CompileStatistics& statistics,
+                        uint32_t thread=0);
+
+    /**
+     * @brief Method for removing added compilations.
+     */
+    void clear();
+
+    /**
+     * @brief Method for writing trace JSON.
+     * Timestamps are relative to earliest compilation.
+     * @param stream Output stream.
+     */
+    void write(std::ostream& stream) const;
+
+private:
+    struct Compilation
+    {
+        std::string name;
+        Calculator::CompileStatistics statistics;
+        uint32_t thread;
+    };
+
+    std::vector<Compilation> m_compilations;
+};
\ No newline at end of file
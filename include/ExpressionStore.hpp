@@ -0,0 +1,182 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Read-only view of compiled expressions store,
+ * that's written by `Calculator::saveStore`. Store
+ * contains no pointers, all references are offsets
+ * from store start, so one mapping of store file is
+ * shared by all processes, that evaluate it.
+ * Functions and variables are referenced by names and
+ * resolved by calculator, that binds store.
+ * Store is validated on opening, so damaged stores
+ * throw SerializationException instead of crashing
+ * on execution.
+ */
+class ExpressionStore
+{
+public:
+
+    // "ECLS" signature.
+    static constexpr uint32_t Signature = 0x534C4345;
+
+    // Has to be increased on any layout change.
+    static constexpr uint32_t Version = 1;
+
+    // Written in native byte order.
+    static constexpr uint32_t ByteOrderMark = 0x01020304;
+
+    /**
+     * @brief Store header. It's placed at store start.
+     */
+    struct Header
+    {
+        uint32_t signature;
+        uint32_t version;
+        uint32_t byteOrder;
+        uint32_t numberSize;
+
+        uint32_t expressionsCount;
+        uint32_t variablesCount;
+        uint32_t functionsCount;
+        uint32_t reserved;
+
+        // Offsets of `Expression` and `Name` arrays.
+        uint64_t expressionsOffset;
+        uint64_t variablesOffset;
+        uint64_t functionsOffset;
+    };
+
+    /**
+     * @brief Variable or function name.
+     */
+    struct Name
+    {
+        uint64_t offset;
+        uint32_t size;
+
+        // Zero for variables.
+        uint32_t numberOfArguments;
+    };
+
+    /**
+     * @brief Compiled expression. Constants are
+     * numbers, program is array of `Instruction`.
+     */
+    struct Expression
+    {
+        uint64_t constantsOffset;
+        uint64_t programOffset;
+        uint32_t constantsCount;
+        uint32_t programSize;
+    };
+
+    /**
+     * @brief RPN lexem. Index is index of expression
+     * constant, store variable or store function.
+     */
+    struct Instruction
+    {
+        uint32_t type;
+        uint32_t index;
+    };
+
+    /**
+     * @brief Constructor, that maps store file
+     * into memory read-only.
+     * @param path Store file path.
+     */
+    explicit ExpressionStore(const std::string& path);
+
+    /**
+     * @brief Constructor of view over store, that's
+     * already in memory, for example in shared memory
+     * segment. Memory is not owned by store and must
+     * be 8 bytes aligned.
+     * @param data Store data.
+     * @param size Store size.
+     */
+    ExpressionStore(const void* data, std::size_t size);
+
+    /**
+     * @brief Destructor. Mapped file is unmapped.
+     */
+    ~ExpressionStore();
+
+    ExpressionStore(const ExpressionStore&) = delete;
+    ExpressionStore& operator=(const ExpressionStore&) = delete;
+
+    /**
+     * @brief Method for getting number of expressions.
+     */
+    std::size_t size() const;
+
+    /**
+     * @brief Method for getting maximal execution
+     * stack depth of stored expressions.
+     */
+    std::size_t stackDepth() const;
+
+    /**
+     * @brief Method for getting store header.
+     */
+    const Header& header() const;
+
+    /**
+     * @brief Method for getting expression by index.
+     * @param index Expression index.
+     */
+    const Expression& expression(std::size_t index) const;
+
+    /**
+     * @brief Method for getting variable name by index.
+     */
+    const Name& variable(std::size_t index) const;
+
+    /**
+     * @brief Method for getting function name by index.
+     */
+    const Name& function(std::size_t index) const;
+
+    /**
+     * @brief Method for getting name string.
+     */
+    std::string_view string(const Name& name) const;
+
+    /**
+     * @brief Method for getting store data at offset.
+     * @tparam T Data type.
+     * @param offset Offset from store start.
+     */
+    template<typename T>
+    const T* at(uint64_t offset) const
+    {
+        return reinterpret_cast<const T*>(m_data + offset);
+    }
+
+private:
+
+    // Checking layout and programs of store.
+    void validate();
+
+    // Checking, that array of `count` values of
+    // type T at offset is inside of store.
+    template<typename T>
+    void checkRange(uint64_t offset, uint64_t count) const;
+
+    // Store data.
+    const unsigned char* m_data;
+
+    // Store size in bytes.
+    std::size_t m_size;
+
+    // Is store mapped by this view.
+    bool m_mapped;
+
+    // Maximal stack depth of expressions.
+    std::size_t m_stackDepth;
+};
\ No newline at end of file
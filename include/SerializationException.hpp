@@ -0,0 +1,12 @@
+#pragma once
+
+#include <stdexcept>
+
+struct SerializationException : std::runtime_error
+{
+    explicit SerializationException(const std::string& string) :
+        std::runtime_error(string)
+    {
+
+    }
+};
\ No newline at end of file
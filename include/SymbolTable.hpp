@@ -0,0 +1,430 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <string>
+#include <string_view>
+#include <deque>
+#include <vector>
+#include <functional>
+#include <memory>
+#include <cstdint>
+
+/**
+ * @brief Flat open addressing table, that maps names
+ * to values. It's probed directly with `std::string_view`
+ * and keeps names, so two names with equal hashes
+ * never alias each other.
+ * Values are kept in stable storage and addressed by
+ * index, so indices and pointers to values stay valid
+ * after insertions.
+ * After setup table can be frozen into perfect hash,
+ * so any lookup takes exactly one probe.
+ * Table can be layered over shared base table. Base
+ * values go first, own values are added on top and
+ * hide base values with the same names. Base values
+ * are accessed as constants, so base table is never
+ * changed.
+ */
+template<typename T>
+class SymbolTable
+{
+public:
+
+    using Index = std::size_t;
+
+    /**
+     * @brief Index, that's returned if there is
+     * no such name in table.
+     */
+    static constexpr Index npos = static_cast<Index>(-1);
+
+    /**
+     * @brief Constructor.
+     */
+    SymbolTable() :
+        m_base(),
+        m_baseSize(0),
+        m_entries(),
+        m_slots(),
+        m_frozen(false),
+        m_displacements(),
+        m_perfectSlots()
+    {
+
+    }
+
+    /**
+     * @brief Constructor of layered table.
+     * @param base Shared table. It must not be
+     * changed while it's shared.
+     */
+    explicit SymbolTable(std::shared_ptr<const SymbolTable> base) :
+        m_base(std::move(base)),
+        m_baseSize(m_base ? m_base->size() : 0),
+        m_entries(),
+        m_slots(),
+        m_frozen(false),
+        m_displacements(),
+        m_perfectSlots()
+    {
+
+    }
+
+    /**
+     * @brief Method for searching value index by name.
+     * Own values are searched first.
+     * @param name Name.
+     * @return Value index or `npos` if there is no such name.
+     */
+    Index find(std::string_view name) const
+    {
+        auto index = findOwn(name);
+
+        if (index != npos)
+        {
+            return m_baseSize + index;
+        }
+
+        return m_base ? m_base->find(name) : npos;
+    }
+
+    /**
+     * @brief Method for inserting value or replacing
+     * existing value with the same name. Base value
+     * is hidden by new own value.
+     * Inserting new name unfreezes table.
+     * @param name Name.
+     * @param value Value.
+     * @return Value index.
+     */
+    Index insert(std::string_view name, T value)
+    {
+        auto index = findOwn(name);
+
+        if (index != npos)
+        {
+            m_entries[index].value = std::move(value);
+            return m_baseSize + index;
+        }
+
+        return append(name, std::move(value));
+    }
+
+    /**
+     * @brief Method for getting index of name, that
+     * adds default value if there is no such name.
+     * @param name Name.
+     * @return Value index.
+     */
+    Index intern(std::string_view name)
+    {
+        auto index = find(name);
+
+        if (index != npos)
+        {
+            return index;
+        }
+
+        return append(name, T());
+    }
+
+    /**
+     * @brief Method for getting own value by index.
+     * Base values are shared, so they can be
+     * accessed only by const method.
+     */
+    T& operator[](Index index)
+    {
+        assert(index >= m_baseSize && "Shared base value can't be changed");
+
+        return m_entries[index - m_baseSize].value;
+    }
+
+    /**
+     * @brief Method for getting value by index.
+     */
+    const T& operator[](Index index) const
+    {
+        return (index < m_baseSize) ?
+            (*m_base)[index] :
+            m_entries[index - m_baseSize].value;
+    }
+
+    /**
+     * @brief Method for getting name of value.
+     * @param index Value index.
+     * @return Name.
+     */
+    const std::string& name(Index index) const
+    {
+        return (index < m_baseSize) ?
+            m_base->name(index) :
+            m_entries[index - m_baseSize].name;
+    }
+
+    /**
+     * @brief Method for getting number of values.
+     */
+    Index size() const
+    {
+        return m_baseSize + m_entries.size();
+    }
+
+    /**
+     * @brief Method for getting number of base
+     * values. They have first indices.
+     */
+    Index sharedSize() const
+    {
+        return m_baseSize;
+    }
+
+    /**
+     * @brief Method for building perfect hash over
+     * current own names. Base table is frozen
+     * separately. Lookups in frozen table take exactly
+     * one probe. Inserting new name unfreezes table.
+     */
+    void freeze()
+    {
+        // Using 4 names per bucket in average and
+        // 80% table load, so displacements are found fast.
+        auto bucketsCount = (m_entries.size() + 3) / 4 + 1;
+        auto slotsCount = m_entries.size() + m_entries.size() / 4 + 1;
+
+        std::vector<std::vector<uint32_t>> buckets(bucketsCount);
+
+        for (uint32_t index = 0; index < m_entries.size(); ++index)
+        {
+            buckets[m_entries[index].hash % bucketsCount].push_back(index);
+        }
+
+        // Placing biggest buckets first
+        std::vector<uint32_t> order(bucketsCount);
+
+        for (uint32_t bucket = 0; bucket < bucketsCount; ++bucket)
+        {
+            order[bucket] = bucket;
+        }
+
+        std::stable_sort(
+            order.begin(),
+            order.end(),
+            [&buckets](uint32_t lhs, uint32_t rhs)
+            {
+                return buckets[lhs].size() > buckets[rhs].size();
+            }
+        );
+
+        m_displacements.assign(bucketsCount, 0);
+        m_perfectSlots.assign(slotsCount, EmptySlot);
+
+        std::vector<std::size_t> placed;
+
+        for (auto bucket : order)
+        {
+            if (buckets[bucket].empty())
+            {
+                break;
+            }
+
+            uint32_t displacement = 0;
+
+            while (true)
+            {
+                placed.clear();
+
+                for (auto index : buckets[bucket])
+                {
+                    auto slot = displacedSlot(m_entries[index].hash, displacement, slotsCount);
+
+                    if (m_perfectSlots[slot] != EmptySlot ||
+                        std::find(placed.begin(), placed.end(), slot) != placed.end())
+                    {
+                        break;
+                    }
+
+                    placed.push_back(slot);
+                }
+
+                if (placed.size() == buckets[bucket].size())
+                {
+                    break;
+                }
+
+                if (++displacement == MaxDisplacement)
+                {
+                    // Can't build perfect hash. Keeping
+                    // open addressing lookups.
+                    m_displacements.clear();
+                    m_perfectSlots.clear();
+                    return;
+                }
+            }
+
+            for (std::size_t i = 0; i < placed.size(); ++i)
+            {
+                m_perfectSlots[placed[i]] = buckets[bucket][i];
+            }
+
+            m_displacements[bucket] = displacement;
+        }
+
+        m_frozen = true;
+    }
+
+    /**
+     * @brief Method for checking is table frozen
+     * into perfect hash.
+     */
+    bool isFrozen() const
+    {
+        return m_frozen;
+    }
+
+private:
+
+    static constexpr uint32_t EmptySlot = static_cast<uint32_t>(-1);
+    static constexpr uint32_t MaxDisplacement = 1U << 20U;
+
+    struct Entry
+    {
+        std::string name;
+        std::size_t hash;
+        T value;
+    };
+
+    static std::size_t hashName(std::string_view name)
+    {
+        return std::hash<std::string_view>()(name);
+    }
+
+    static std::size_t displacedSlot(std::size_t hash,
+                                     uint32_t displacement,
+                                     std::size_t slotsCount)
+    {
+        // splitmix64 finalizer
+        uint64_t value = hash + (displacement + 1) * 0x9E3779B97F4A7C15ULL;
+
+        value = (value ^ (value >> 30U)) * 0xBF58476D1CE4E5B9ULL;
+        value = (value ^ (value >> 27U)) * 0x94D049BB133111EBULL;
+        value = value ^ (value >> 31U);
+
+        return static_cast<std::size_t>(value % slotsCount);
+    }
+
+    Index findOwn(std::string_view name) const
+    {
+        auto hash = hashName(name);
+
+        if (m_frozen)
+        {
+            auto index = m_perfectSlots[perfectSlot(hash)];
+
+            if (index != EmptySlot &&
+                m_entries[index].hash == hash &&
+                m_entries[index].name == name)
+            {
+                return index;
+            }
+
+            return npos;
+        }
+
+        if (m_slots.empty())
+        {
+            return npos;
+        }
+
+        auto mask = m_slots.size() - 1;
+
+        for (auto slot = hash & mask; ; slot = (slot + 1) & mask)
+        {
+            auto index = m_slots[slot];
+
+            if (index == EmptySlot)
+            {
+                return npos;
+            }
+
+            if (m_entries[index].hash == hash &&
+                m_entries[index].name == name)
+            {
+                return index;
+            }
+        }
+    }
+
+
+    std::size_t perfectSlot(std::size_t hash) const
+    {
+        return displacedSlot(
+            hash,
+            m_displacements[hash % m_displacements.size()],
+            m_perfectSlots.size()
+        );
+    }
+
+    Index append(std::string_view name, T value)
+    {
+        auto hash = hashName(name);
+
+        m_entries.push_back(Entry{std::string(name), hash, std::move(value)});
+
+        // Keeping load factor under 3/4
+        if (m_entries.size() * 4 > m_slots.size() * 3)
+        {
+            rehash(m_slots.empty() ? 16 : m_slots.size() * 2);
+        }
+        else
+        {
+            place(m_entries.size() - 1);
+        }
+
+        m_frozen = false;
+        m_displacements.clear();
+        m_perfectSlots.clear();
+
+        return m_baseSize + m_entries.size() - 1;
+    }
+
+    void rehash(std::size_t slotsCount)
+    {
+        m_slots.assign(slotsCount, EmptySlot);
+
+        for (std::size_t index = 0; index < m_entries.size(); ++index)
+        {
+            place(index);
+        }
+    }
+
+    void place(std::size_t index)
+    {
+        auto mask = m_slots.size() - 1;
+
+        auto slot = m_entries[index].hash & mask;
+
+        while (m_slots[slot] != EmptySlot)
+        {
+            slot = (slot + 1) & mask;
+        }
+
+        m_slots[slot] = static_cast<uint32_t>(index);
+    }
+
+    // Shared table under own values.
+    std::shared_ptr<const SymbolTable> m_base;
+    Index m_baseSize;
+
+    // Values storage. Deque keeps references valid.
+    std::deque<Entry> m_entries;
+
+    // Open addressing slots with value indices.
+    std::vector<uint32_t> m_slots;
+
+    // Perfect hash data. Used after freezing.
+    bool m_frozen;
+    std::vector<uint32_t> m_displacements;
+    std::vector<uint32_t> m_perfectSlots;
+};
\ No newline at end of file
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+
+/**
+ * @brief Accuracy tiers of built-in math functions.
+ */
+enum class MathAccuracy
+{
+    // Standard library routines. They are correctly
+    // rounded in almost all cases.
+    CorrectlyRounded,
+
+    // Polynomial approximations with error
+    // about 1 ULP.
+    Ulp1,
+
+    // Short polynomial approximations with
+    // relative error about 1e-7.
+    Fast
+};
+
+/**
+ * @brief Math functions over arrays of values.
+ * Polynomial tiers are written without branches
+ * in main loops, so they are vectorized by compiler.
+ * Arguments, that are out of approximation range
+ * (huge, non finite, subnormal results), are
+ * computed with standard library routines.
+ * Input and output arrays can be the same array.
+ */
+namespace VectorMath
+{
+    /**
+     * @brief Sine. Polynomial tiers reduce arguments
+     * up to 1e5 by absolute value.
+     */
+    void sin(const double* input, double* output, std::size_t count, MathAccuracy accuracy);
+
+    /**
+     * @brief Cosine. Polynomial tiers reduce arguments
+     * up to 1e5 by absolute value.
+     */
+    void cos(const double* input, double* output, std::size_t count, MathAccuracy accuracy);
+
+    /**
+     * @brief Exponent.
+     */
+    void exp(const double* input, double* output, std::size_t count, MathAccuracy accuracy);
+
+    /**
+     * @brief Natural logarithm.
+     */
+    void log(const double* input, double* output, std::size_t count, MathAccuracy accuracy);
+
+    /**
+     * @brief Square root. It's correctly rounded
+     * in every tier.
+     */
+    void sqrt(const double* input, double* output, std::size_t count, MathAccuracy accuracy);
+
+    /**
+     * @brief Power. `Fast` tier computes `exp(y * log(x))`
+     * for positive bases, other tiers use standard
+     * library routine, because `exp(y * log(x))` is
+     * not accurate to 1 ULP.
+     */
+    void pow(const double* base,
+             const double* exponent,
+             double* output,
+             std::size_t count,
+             MathAccuracy accuracy);
+
+    /**
+     * @brief Sum of values. Several accumulators are
+     * used, so additions are vectorized by compiler.
+     */
+    double sum(const double* input, std::size_t count);
+
+    /**
+     * @brief Minimal value. NaN values are skipped.
+     */
+    double min(const double* input, std::size_t count);
+
+    /**
+     * @brief Maximal value. NaN values are skipped.
+     */
+    double max(const double* input, std::size_t count);
+
+    /**
+     * @brief Dot product of two arrays.
+     */
+    double dot(const double* lhs, const double* rhs, std::size_t count);
+}
\ No newline at end of file
@@ -1,112 +1,175 @@
 #include <system_error>
+#include <algorithm>
 #include <functional>
 #include <ParsingException.hpp>
 #include <iostream>
 #include <StatementException.hpp>
 #include <cmath>
 #include <CalculationException.hpp>
+#include <charconv>
+#include <limits>
+#include <utility>
 #include "Calculator.hpp"
 
+namespace
+{
+    Calculator::NumberType parseNumber(const char* begin, const char* end)
+    {
+        // `std::from_chars` does not accept plus sign
+        auto numberBegin = (*begin == '+') ? begin + 1 : begin;
+
+        Calculator::NumberType value = 0;
+
+        auto result = std::from_chars(numberBegin, end, value);
+
+        if (result.ec != std::errc() ||
+            result.ptr != end)
+        {
+            throw ParsingException(std::string(begin, end) + " is not a number");
+        }
+
+        return value;
+    }
+}
+
 Calculator::Calculator() :
-    m_functions(),
+    m_functions(sharedFunctions(0)),
+    m_functionSets(0),
     m_variables(),
     m_constants(),
+    m_tables(),
     m_expression(),
+    m_backend(Backend::Stack),
+    m_program(),
+    m_programThreaded(false),
+    m_registerProgram(),
+    m_registerSources(),
+    m_registers(),
+    m_registerResult(nullptr),
+    m_programConstants(),
+    m_programVariables(),
+    m_referencedVariables(),
+    m_variableProvider(nullptr),
+    m_providerContext(nullptr),
+    m_variableRequests(),
+    m_requestedSlots(),
     m_braceTest(0),
     m_executionStack(),
-    m_stringHash()
+    m_profiling(false),
+    m_profile(),
+    m_profiledExecutions(0),
+    m_compileArena(),
+    m_mathAccuracy(MathAccuracy::CorrectlyRounded),
+    m_batchWorkspace(),
+    m_parameters(nullptr),
+    m_polynomials(),
+    m_streams(),
+    m_randomSeed(0),
+    m_generalExpression(),
+    m_generalPolynomials(0),
+    m_reductions(),
+    m_reductionColumns(),
+    m_reductionBuffer(),
+    m_quadrature(),
+    m_legendreNodes(),
+    m_legendreWeights(),
+    m_quadratureIntervals(),
+    m_quadraturePoints(),
+    m_quadratureValues(),
+    m_store(nullptr),
+    m_storeFunctions(),
+    m_storeVariables(),
+    m_storeReferences()
+{
+
+}
+
+void Calculator::fillOperators(FunctionTable& functions)
 {
-    addFunction(
+    insertFunction(
+        functions,
         Calculator::Function(
             "+",
             2, // Binary function. Undefined number of args
             1,
-            [](Calculator::ArgumentsStack& stack) -> NumberType
+            &Calculator::add,
+            [](const NumberType* const* arguments, NumberType* result, std::size_t count, MathAccuracy)
             {
-                auto rightValue = stack.back();
-                stack.pop_back();
-
-                auto leftValue = stack.back();
-                stack.pop_back();
-
-                return leftValue + rightValue;
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    result[i] = arguments[0][i] + arguments[1][i];
+                }
             }
         )
     );
 
-    addFunction(
+    insertFunction(
+        functions,
         Calculator::Function(
             "-",
             2, // Binary function. Undefined number of args
             1,
-            [](Calculator::ArgumentsStack& stack) -> NumberType
+            &Calculator::subtract,
+            [](const NumberType* const* arguments, NumberType* result, std::size_t count, MathAccuracy)
             {
-                auto rightValue = stack.back();
-                stack.pop_back();
-
-                auto leftValue = stack.back();
-                stack.pop_back();
-
-                return leftValue - rightValue;
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    result[i] = arguments[0][i] - arguments[1][i];
+                }
             }
         )
     );
 
-    addFunction(
+    insertFunction(
+        functions,
         Calculator::Function(
             "*",
             2, // Binary function. Undefined number of args
             2,
-            [](Calculator::ArgumentsStack& stack) -> NumberType
+            &Calculator::multiply,
+            [](const NumberType* const* arguments, NumberType* result, std::size_t count, MathAccuracy)
             {
-                auto rightValue = stack.back();
-                stack.pop_back();
-
-                auto leftValue = stack.back();
-                stack.pop_back();
-
-                return leftValue * rightValue;
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    result[i] = arguments[0][i] * arguments[1][i];
+                }
             }
         )
     );
 
-    addFunction(
+    insertFunction(
+        functions,
         Calculator::Function(
             "/",
             2, // Binary function. Undefined number of args
             2,
-            [](Calculator::ArgumentsStack& stack) -> NumberType
+            &Calculator::divide,
+            [](const NumberType* const* arguments, NumberType* result, std::size_t count, MathAccuracy)
             {
-                auto rightValue = stack.back();
-                stack.pop_back();
-
-                auto leftValue = stack.back();
-                stack.pop_back();
-
-                return leftValue / rightValue;
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    result[i] = arguments[0][i] / arguments[1][i];
+                }
             }
         )
     );
 
-    addFunction(
+    insertFunction(
+        functions,
         Calculator::Function(
             "^",
             2, // Binary function. Undefined number of args
             3,
-            [](Calculator::ArgumentsStack& stack) -> NumberType
+            &Calculator::power,
+            [](const NumberType* const* arguments, NumberType* result, std::size_t count, MathAccuracy accuracy)
             {
-                auto rightValue = stack.back();
-                stack.pop_back();
-
-                auto leftValue = stack.back();
-                stack.pop_back();
-
-                return std::pow(leftValue, rightValue);
+                VectorMath::pow(arguments[0], arguments[1], result, count, accuracy);
             }
         )
     );
 
-    addFunction(
+    insertFunction(
+        functions,
         Calculator::Function(
             "!",
             1, // Binary function. Undefined number of args
@@ -122,23 +185,163 @@ Calculator::Calculator() :
     );
 }
 
-void Calculator::setExpression(std::string expression, bool optimize)
+Calculator::NumberType Calculator::add(ArgumentsStack& stack)
 {
-    m_expression.clear();
+    auto rightValue = stack.back();
+    stack.pop_back();
+
+    auto leftValue = stack.back();
+    stack.pop_back();
+
+    return leftValue + rightValue;
+}
+
+Calculator::NumberType Calculator::subtract(ArgumentsStack& stack)
+{
+    auto rightValue = stack.back();
+    stack.pop_back();
+
+    auto leftValue = stack.back();
+    stack.pop_back();
+
+    return leftValue - rightValue;
+}
+
+Calculator::NumberType Calculator::multiply(ArgumentsStack& stack)
+{
+    auto rightValue = stack.back();
+    stack.pop_back();
+
+    auto leftValue = stack.back();
+    stack.pop_back();
+
+    return leftValue * rightValue;
+}
+
+Calculator::NumberType Calculator::divide(ArgumentsStack& stack)
+{
+    auto rightValue = stack.back();
+    stack.pop_back();
 
-    // Splitting on lexems
-    LexemStack lexems;
+    auto leftValue = stack.back();
+    stack.pop_back();
 
-    splitOnLexems(std::move(expression), lexems);
+    return leftValue / rightValue;
+}
 
-    pushLexems(lexems);
+Calculator::NumberType Calculator::power(ArgumentsStack& stack)
+{
+    auto rightValue = stack.back();
+    stack.pop_back();
 
-    performValidation();
+    auto leftValue = stack.back();
+    stack.pop_back();
+
+    return std::pow(leftValue, rightValue);
+}
 
-    if (optimize)
+void Calculator::setExpression(std::string_view expression,
+                               bool optimize,
+                               CompileStatistics* statistics)
+{
+    using Clock = std::chrono::steady_clock;
+
+    Clock::time_point phaseStart;
+
+    auto startPhase = [&phaseStart, statistics]()
     {
-        performOptimization();
+        if (statistics)
+        {
+            phaseStart = Clock::now();
+        }
+    };
+
+    auto finishPhase = [&phaseStart, statistics](std::chrono::nanoseconds CompileStatistics::* time)
+    {
+        if (statistics)
+        {
+            statistics->*time = Clock::now() - phaseStart;
+        }
+    };
+
+    if (statistics)
+    {
+        *statistics = CompileStatistics();
+        statistics->startTime = Clock::now();
+    }
+
+    clearExpression();
+
+    // Containers from previous compilation are
+    // already destroyed.
+    m_compileArena.reset();
+
+    std::size_t folds = 0;
+
+    try
+    {
+        // Splitting on lexems
+        LexemBuffer lexems(&m_compileArena);
+
+        startPhase();
+        splitOnLexems(expression, lexems);
+        finishPhase(&CompileStatistics::splittingTime);
+
+        startPhase();
+        pushLexems(lexems);
+        finishPhase(&CompileStatistics::pushingTime);
+
+        startPhase();
+        performValidation();
+        finishPhase(&CompileStatistics::validationTime);
+
+        if (statistics)
+        {
+            statistics->lexemsCount = lexems.size();
+            statistics->rpnLength = m_expression.size();
+        }
+
+        inlineFunctions();
+        extractReductions();
+
+        if (optimize)
+        {
+            startPhase();
+            folds = performOptimization();
+            detectPolynomials();
+            finishPhase(&CompileStatistics::optimizationTime);
+        }
+
+        instantiateStreams();
+
+        startPhase();
+        buildProgram();
+        finishPhase(&CompileStatistics::programTime);
+    }
+    catch (...)
+    {
+        // Partial expression can't be executed
+        clearExpression();
+        throw;
     }
+
+    if (statistics)
+    {
+        statistics->optimizedLength = m_expression.size();
+        // Without return instruction
+        statistics->instructionsCount = (m_backend == Backend::Register) ?
+            m_registerProgram.size() :
+            m_program.size() - 1;
+        statistics->foldsCount = folds;
+        statistics->maxStackDepth = stackDepth(m_expression);
+    }
+
+    resetProfile();
+}
+
+void Calculator::setMemoryResource(std::pmr::memory_resource* resource)
+{
+    m_compileArena.setUpstream(resource);
 }
 
 void Calculator::getRPN(LexemStack& lexems)
@@ -150,7 +353,7 @@ void Calculator::performValidation()
 {
     uint32_t values = 0;
 
-    Function* func;
+    const Function* func;
 
     for (auto&& lexem : m_expression)
     {
@@ -158,12 +361,14 @@ void Calculator::performValidation()
         {
         case Lexem::Type::Constant:
         case Lexem::Type::Variable:
+        case Lexem::Type::Reduction:
+        case Lexem::Type::Parameter:
             values += 1;
             break;
 
         case Lexem::Type::Function:
 
-            func = std::get<Function*>(lexem.value);
+            func = std::get<const Function*>(lexem.value);
 
             if (func->numberOfArguments > values)
             {
@@ -188,7 +393,7 @@ void Calculator::performValidation()
     }
 }
 
-void Calculator::noneState(char*& string, LexemStack& /* lexems */, int& state)
+void Calculator::noneState(const char*& string, LexemBuffer& /* lexems */, int& state)
 {
     if (isdigit(*string) ||
         *string == '.' ||
@@ -217,7 +422,7 @@ void Calculator::noneState(char*& string, LexemStack& /* lexems */, int& state)
     ++string;
 }
 
-void Calculator::numberState(char*& string, LexemStack& lexems, int& state)
+void Calculator::numberState(const char*& string, LexemBuffer& lexems, int& state)
 {
     auto start = string;
     auto dotFound = false;
@@ -259,26 +464,10 @@ void Calculator::numberState(char*& string, LexemStack& lexems, int& state)
                 return;
             }
 
-            NumberType value;
-
-            try
-            {
-                auto terminator_bu = *string;
-                *string = '\0';
-
-                value = std::atof(start);
-
-                *string = terminator_bu;
-            }
-            catch (std::invalid_argument& argument)
-            {
-                throw ParsingException(std::string(start, len) + " is not a number");
-            }
-
             lexems.emplace_back(
                 Calculator::Lexem(
                     Calculator::Lexem::Type::Constant,
-                    value
+                    parseNumber(start, string)
                 )
             );
 
@@ -306,26 +495,10 @@ void Calculator::numberState(char*& string, LexemStack& lexems, int& state)
             return;
         }
 
-        NumberType value;
-
-        try
-        {
-            auto terminator_bu = *string;
-            *string = '\0';
-
-            value = std::atof(start);
-
-            *string = terminator_bu;
-        }
-        catch (std::invalid_argument& argument)
-        {
-            throw ParsingException(std::string(start, len) + " is not a number");
-        }
-
         lexems.emplace_back(
             Calculator::Lexem(
                 Calculator::Lexem::Type::Constant,
-                value
+                parseNumber(start, string)
             )
         );
     }
@@ -361,7 +534,7 @@ Calculator::SymbolType Calculator::getSymbolType(char c)
     return SymbolType::Garbage;
 }
 
-void Calculator::stringState(char*& string, LexemStack& lexems, int& state)
+void Calculator::stringState(const char*& string, LexemBuffer& lexems, int& state)
 {
     Lexem lexem;
 
@@ -419,13 +592,28 @@ void Calculator::stringState(char*& string, LexemStack& lexems, int& state)
         throw ParsingException("Internal error");
     }
 
-    auto nameHash = m_stringHash(std::string_view(start, static_cast<std::string::size_type>(size)));
+    auto name = std::string_view(start, static_cast<std::string::size_type>(size));
 
-    auto function = m_functions.find(nameHash);
+    if (m_parameters)
+    {
+        auto parameter = std::find(m_parameters->begin(), m_parameters->end(), name);
 
-    if (function != m_functions.end())
+        if (parameter != m_parameters->end())
+        {
+            lexem.value = static_cast<std::size_t>(std::distance(m_parameters->begin(), parameter));
+            lexem.type = Lexem::Type::Parameter;
+
+            lexems.emplace_back(std::move(lexem));
+            state = 0;
+            return;
+        }
+    }
+
+    auto function = m_functions.find(name);
+
+    if (function != m_functions.npos)
     {
-        lexem.value = &function->second;
+        lexem.value = &std::as_const(m_functions)[function];
         lexem.type = Lexem::Type::Function;
 
         lexems.emplace_back(std::move(lexem));
@@ -433,11 +621,11 @@ void Calculator::stringState(char*& string, LexemStack& lexems, int& state)
         return;
     }
 
-    auto constant = m_constants.find(nameHash);
+    auto constant = m_constants.find(name);
 
-    if (constant != m_constants.end())
+    if (constant != m_constants.npos)
     {
-        lexem.value = constant->second;
+        lexem.value = std::as_const(m_constants)[constant];
         lexem.type = Lexem::Type::Constant;
 
         lexems.emplace_back(std::move(lexem));
@@ -446,7 +634,7 @@ void Calculator::stringState(char*& string, LexemStack& lexems, int& state)
     }
 
     // It's variable then
-    lexem.value = nameHash;
+    lexem.value = m_variables.intern(name);
     lexem.type = Lexem::Type::Variable;
 
     lexems.emplace_back(std::move(lexem));
@@ -454,7 +642,7 @@ void Calculator::stringState(char*& string, LexemStack& lexems, int& state)
     state = 0; // None state
 }
 
-void Calculator::braceState(char*& string, LexemStack& lexems, int& state)
+void Calculator::braceState(const char*& string, LexemBuffer& lexems, int& state)
 {
     if (*string == '(' ||
         *string == '[' ||
@@ -517,9 +705,9 @@ void Calculator::braceState(char*& string, LexemStack& lexems, int& state)
     state = 0;
 }
 
-void Calculator::splitOnLexems(std::string string, LexemStack& lexems)
+void Calculator::splitOnLexems(std::string_view string, LexemBuffer& lexems)
 {
-    using LexemParserState = void(Calculator::*)(char*&, LexemStack&, int&);
+    using LexemParserState = void(Calculator::*)(const char*&, LexemBuffer&, int&);
 
     // 0 - none state.
     // 1 - parsing number
@@ -535,14 +723,17 @@ void Calculator::splitOnLexems(std::string string, LexemStack& lexems)
 
     auto state = 0;
 
-    auto s = string.c_str();
+    // States are relying on null terminator
+    std::pmr::string terminated(string, &m_compileArena);
+
+    auto s = terminated.c_str();
 
     m_braceTest = 0;
     while (*s)
     {
         int newState = -1;
 
-        ((*this).*states[state])(const_cast<char*&>(s), lexems, newState);
+        ((*this).*states[state])(s, lexems, newState);
 
         if (newState > -1)
         {
@@ -558,14 +749,45 @@ void Calculator::splitOnLexems(std::string string, LexemStack& lexems)
 
 void Calculator::addFunction(Calculator::Function func)
 {
-    m_functions[m_stringHash(func.name)] = std::move(func);
+    auto name = func.name;
+
+    auto previous = m_functions.find(name);
+    auto index = m_functions.insert(name, std::move(func));
+
+    // Shared function is hidden by own one, so
+    // compiled expression uses own one.
+    if (previous != m_functions.npos &&
+        previous != index)
+    {
+        rebindFunction(&std::as_const(m_functions)[previous], &std::as_const(m_functions)[index]);
+    }
+
+    // Program can contain replaced operator
+    if (!m_expression.empty())
+    {
+        buildProgram();
+    }
 }
 
-void Calculator::pushLexems(LexemStack& lexems)
+void Calculator::pushLexems(LexemBuffer& lexems)
 {
     m_expression.clear();
 
-    LexemStack stack;
+    LexemBuffer stack(&m_compileArena);
+
+    // Are stacked functions called before their
+    // arguments, instead of being operators.
+    std::pmr::vector<bool> calls(&m_compileArena);
+
+    // Is value expected next
+    auto operand = true;
+
+    auto popStack = [&]()
+    {
+        m_expression.emplace_back(std::move(stack.back()));
+        stack.pop_back();
+        calls.pop_back();
+    };
 
     for (auto&& lexem : lexems)
     {
@@ -575,31 +797,59 @@ void Calculator::pushLexems(LexemStack& lexems)
             break;
         case Lexem::Type::Constant: // passthrough
         case Lexem::Type::Variable:
+        case Lexem::Type::Parameter:
             m_expression.emplace_back(std::move(lexem));
+            operand = false;
             break;
         case Lexem::Type::Function:
-            if (!stack.empty() &&
-                stack.back().type != Lexem::Type::BraceOpen &&
-                std::get<Function*>(lexem.value)->priority <= std::get<Function*>(stack.back().value)->priority)
+            // Operator finishes called functions and
+            // operators with higher or same priority
+            while (!operand &&
+                   !stack.empty() &&
+                   stack.back().type != Lexem::Type::BraceOpen &&
+                   (calls.back() ||
+                    std::get<const Function*>(lexem.value)->priority <= std::get<const Function*>(stack.back().value)->priority))
             {
-                m_expression.emplace_back(std::move(stack.back()));
-                stack.pop_back();
+                popStack();
             }
 
+        {
+            // Unary operator after value is postfix one,
+            // so operator is expected after it.
+            auto postfix = !operand && std::get<const Function*>(lexem.value)->numberOfArguments == 1;
+
             stack.emplace_back(std::move(lexem));
+            calls.push_back(operand);
+            operand = !postfix;
 
             break;
+        }
         case Lexem::Type::BraceOpen:
             stack.push_back(std::move(lexem));
+            calls.push_back(false);
+            operand = true;
             break;
         case Lexem::Type::BraceClosed:
             while (stack.back().type != Lexem::Type::BraceOpen)
             {
-                m_expression.emplace_back(std::move(stack.back()));
-                stack.pop_back();
+                popStack();
             }
 
             stack.pop_back();
+            calls.pop_back();
+
+            operand = false;
+
+            break;
+        case Lexem::Type::Comma:
+            // Argument is finished
+            while (!stack.empty() &&
+                   stack.back().type != Lexem::Type::BraceOpen)
+            {
+                popStack();
+            }
+
+            operand = true;
 
             break;
 
@@ -610,21 +860,37 @@ void Calculator::pushLexems(LexemStack& lexems)
 
     while (!stack.empty())
     {
-        m_expression.emplace_back(std::move(stack.back()));
-        stack.pop_back();
+        popStack();
     }
 }
 
-void Calculator::setVariable(std::string name, NumberType value)
+void Calculator::setVariable(std::string_view name, NumberType value)
+{
+    setVariable(variableHandle(name), value);
+}
+
+Calculator::VariableHandle Calculator::variableHandle(std::string_view name)
 {
-    m_variables[m_stringHash(name)] = value;
+    return {m_variables.intern(name)};
 }
 
-void Calculator::deleteVariable(const std::string& name)
+void Calculator::setVariable(VariableHandle handle, NumberType value)
 {
-    auto search_result = m_variables.find(m_stringHash(name));
+    // Elements are cleared without releasing memory
+    auto& variable = m_variables[handle.slot];
 
-    if (search_result == m_variables.end())
+    variable.value = value;
+    variable.defined = true;
+    variable.array = false;
+    variable.elements.clear();
+}
+
+void Calculator::deleteVariable(std::string_view name)
+{
+    auto search_result = m_variables.find(name);
+
+    if (search_result == m_variables.npos ||
+        !m_variables[search_result].defined)
     {
         throw std::invalid_argument(
             std::string("There is no variable \"")
@@ -633,17 +899,30 @@ void Calculator::deleteVariable(const std::string& name)
         );
     }
 
-    m_variables.erase(search_result);
+    // Slot is kept, because it can be used
+    // by expression.
+    m_variables[search_result].defined = false;
+    m_variables[search_result].array = false;
+    m_variables[search_result].elements.clear();
+}
+
+void Calculator::freezeRegistry()
+{
+    m_functions.freeze();
+    m_variables.freeze();
+    m_constants.freeze();
 }
 
-void Calculator::performOptimization()
+std::size_t Calculator::performOptimization()
 {
-    LexemStack stack;
+    LexemBuffer stack(&m_compileArena);
+
+    std::size_t folds = 0;
 
     m_executionStack.clear();
 
     uint32_t args = 0;
-    Function* func = nullptr;
+    const Function* func = nullptr;
 
     for (auto&& lexem : m_expression)
     {
@@ -654,6 +933,7 @@ void Calculator::performOptimization()
             break;
 
         case Lexem::Type::Variable:
+        case Lexem::Type::Reduction:
             for (auto&& el : m_executionStack)
             {
                 stack.emplace_back(
@@ -671,14 +951,17 @@ void Calculator::performOptimization()
             break;
 
         case Lexem::Type::Function:
-            func = std::get<Function*>(lexem.value);
+            func = std::get<const Function*>(lexem.value);
             args = func->numberOfArguments;
 
-            if (m_executionStack.size() >= args)
+            // Stateful functions are never folded
+            if (m_executionStack.size() >= args && !isStream(func))
             {
                 m_executionStack.emplace_back(
-                    func->function(m_executionStack)
+                    func->call(m_executionStack)
                 );
+
+                ++folds;
             }
             else
             {
@@ -714,47 +997,168 @@ void Calculator::performOptimization()
         );
     }
 
-    m_expression = std::move(stack);
+    // Reusing expression memory
+    m_expression.assign(stack.begin(), stack.end());
+
+    return folds;
+}
+
+std::size_t Calculator::stackDepth(const LexemStack& expression) const
+{
+    std::size_t depth = 0;
+    std::size_t maxDepth = 0;
+
+    for (auto&& lexem : expression)
+    {
+        switch (lexem.type)
+        {
+        case Lexem::Type::Constant:
+        case Lexem::Type::Variable:
+        case Lexem::Type::Reduction:
+            maxDepth = std::max(maxDepth, ++depth);
+            break;
+
+        case Lexem::Type::Function:
+            depth -= std::get<const Function*>(lexem.value)->numberOfArguments;
+            maxDepth = std::max(maxDepth, ++depth);
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    return maxDepth;
 }
 
 Calculator::NumberType Calculator::execute()
 {
-    auto variableValue = m_variables.end();
+    if (m_expression.empty())
+    {
+        throw StatementException("Unbalanced expression");
+    }
+
+    std::size_t undefinedSlot = m_variables.npos;
+
+    switch (prepareExecution(undefinedSlot))
+    {
+    case ExecutionStatus::UndefinedVariable:
+        throw CalculationException(
+            std::string("No variable \"")
+                .append(m_variables.name(undefinedSlot))
+                .append("\" defined")
+        );
+
+    case ExecutionStatus::ArraySizeMismatch:
+        throw CalculationException("Arrays in reduction have different sizes");
+
+    default:
+        break;
+    }
+
+    if (m_profiling)
+    {
+        return executeExpression<true>();
+    }
+
+    return executeProgram();
+}
+
+Calculator::ExecutionResult Calculator::tryExecute()
+{
+    ExecutionResult result = {
+        ExecutionStatus::Success,
+        std::numeric_limits<NumberType>::quiet_NaN()
+    };
+
+    if (m_expression.empty())
+    {
+        result.status = ExecutionStatus::UnbalancedExpression;
+        return result;
+    }
+
+    std::size_t undefinedSlot = m_variables.npos;
+
+    result.status = prepareExecution(undefinedSlot);
+
+    if (result.status != ExecutionStatus::Success)
+    {
+        return result;
+    }
+
+    // Failed compilation clears expression, so
+    // non-empty one has complete program.
+    result.value = m_profiling ? executeExpression<true>() : executeProgram();
+
+    return result;
+}
+
+template<bool Profile>
+Calculator::NumberType Calculator::executeExpression()
+{
+    using Clock = std::chrono::steady_clock;
+
+    Clock::time_point start;
+
+    auto entry = m_profile.begin();
+
+    if constexpr (Profile)
+    {
+        ++m_profiledExecutions;
+    }
 
     m_executionStack.clear();
 
     for (auto&& lexem : m_expression)
     {
+        if constexpr (Profile)
+        {
+            start = Clock::now();
+        }
+
         switch (lexem.type)
         {
         case Lexem::Type::Constant:
             m_executionStack.push_back(std::get<NumberType>(lexem.value));
             break;
         case Lexem::Type::Variable:
-            variableValue = m_variables.find(std::get<std::size_t>(lexem.value));
+        {
+            auto& variable = m_variables[std::get<std::size_t>(lexem.value)];
 
-            if (variableValue == m_variables.end())
+            if (!variable.defined && !variable.provided)
             {
                 throw CalculationException(
                     std::string("No variable \"")
-                        .append(std::to_string(std::get<std::size_t>(lexem.value)))
+                        .append(m_variables.name(std::get<std::size_t>(lexem.value)))
                         .append("\" defined")
                 );
             }
 
-            m_executionStack.push_back(variableValue->second);
+            m_executionStack.push_back(variable.value);
 
             break;
+        }
 
         case Lexem::Type::Function:
             m_executionStack.push_back(
-                std::get<Function*>(lexem.value)->function(m_executionStack)
+                std::get<const Function*>(lexem.value)->call(m_executionStack)
             );
             break;
 
+        case Lexem::Type::Reduction:
+            m_executionStack.push_back(m_reductions[std::get<std::size_t>(lexem.value)].value);
+            break;
+
         default:
             throw StatementException("Unexpected lexem detected");
         }
+
+        if constexpr (Profile)
+        {
+            entry->time += Clock::now() - start;
+            ++entry->calls;
+            ++entry;
+        }
     }
 
     if (m_executionStack.size() != 1) // Result
@@ -765,9 +1169,10 @@ Calculator::NumberType Calculator::execute()
     return m_executionStack.front();
 }
 
-void Calculator::addBasicFunctions()
+void Calculator::fillBasicFunctions(FunctionTable& functions)
 {
-    addFunction(
+    insertFunction(
+        functions,
         Calculator::Function(
             "abs",
             1, // One arg
@@ -778,11 +1183,19 @@ void Calculator::addBasicFunctions()
                 stack.pop_back();
 
                 return std::abs(value);
+            },
+            [](const NumberType* const* arguments, NumberType* result, std::size_t count, MathAccuracy)
+            {
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    result[i] = std::abs(arguments[0][i]);
+                }
             }
         )
     );
 
-    addFunction(
+    insertFunction(
+        functions,
         Calculator::Function(
             "sin",
             1, // One arg
@@ -793,11 +1206,16 @@ void Calculator::addBasicFunctions()
                 stack.pop_back();
 
                 return std::sin(value);
+            },
+            [](const NumberType* const* arguments, NumberType* result, std::size_t count, MathAccuracy accuracy)
+            {
+                VectorMath::sin(arguments[0], result, count, accuracy);
             }
         )
     );
 
-    addFunction(
+    insertFunction(
+        functions,
         Calculator::Function(
             "cos",
             1, // One arg
@@ -808,11 +1226,16 @@ void Calculator::addBasicFunctions()
                 stack.pop_back();
 
                 return std::cos(value);
+            },
+            [](const NumberType* const* arguments, NumberType* result, std::size_t count, MathAccuracy accuracy)
+            {
+                VectorMath::cos(arguments[0], result, count, accuracy);
             }
         )
     );
 
-    addFunction(
+    insertFunction(
+        functions,
         Calculator::Function(
             "tan",
             1, // One arg
@@ -827,7 +1250,8 @@ void Calculator::addBasicFunctions()
         )
     );
 
-    addFunction(
+    insertFunction(
+        functions,
         Calculator::Function(
             "acos",
             1, // One arg
@@ -842,7 +1266,8 @@ void Calculator::addBasicFunctions()
         )
     );
 
-    addFunction(
+    insertFunction(
+        functions,
         Calculator::Function(
             "asin",
             1, // One arg
@@ -857,7 +1282,8 @@ void Calculator::addBasicFunctions()
         )
     );
 
-    addFunction(
+    insertFunction(
+        functions,
         Calculator::Function(
             "tan",
             1, // One arg
@@ -872,7 +1298,8 @@ void Calculator::addBasicFunctions()
         )
     );
 
-    addFunction(
+    insertFunction(
+        functions,
         Calculator::Function(
             "atan2",
             2, // Two args
@@ -890,7 +1317,60 @@ void Calculator::addBasicFunctions()
         )
     );
 
-    addFunction(
+    insertFunction(
+        functions,
+        Calculator::Function(
+            "min",
+            2, // Two args
+            4,
+            [](Calculator::ArgumentsStack& stack) -> NumberType
+            {
+                auto value2 = stack.back();
+                stack.pop_back();
+
+                auto value1 = stack.back();
+                stack.pop_back();
+
+                return std::min(value1, value2);
+            },
+            [](const NumberType* const* arguments, NumberType* result, std::size_t count, MathAccuracy)
+            {
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    result[i] = std::min(arguments[0][i], arguments[1][i]);
+                }
+            }
+        )
+    );
+
+    insertFunction(
+        functions,
+        Calculator::Function(
+            "max",
+            2, // Two args
+            4,
+            [](Calculator::ArgumentsStack& stack) -> NumberType
+            {
+                auto value2 = stack.back();
+                stack.pop_back();
+
+                auto value1 = stack.back();
+                stack.pop_back();
+
+                return std::max(value1, value2);
+            },
+            [](const NumberType* const* arguments, NumberType* result, std::size_t count, MathAccuracy)
+            {
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    result[i] = std::max(arguments[0][i], arguments[1][i]);
+                }
+            }
+        )
+    );
+
+    insertFunction(
+        functions,
         Calculator::Function(
             "cosh",
             1, // One arg
@@ -905,7 +1385,8 @@ void Calculator::addBasicFunctions()
         )
     );
 
-    addFunction(
+    insertFunction(
+        functions,
         Calculator::Function(
             "sinh",
             1, // One arg
@@ -920,7 +1401,8 @@ void Calculator::addBasicFunctions()
         )
     );
 
-    addFunction(
+    insertFunction(
+        functions,
         Calculator::Function(
             "tanh",
             1, // One arg
@@ -935,7 +1417,8 @@ void Calculator::addBasicFunctions()
         )
     );
 
-    addFunction(
+    insertFunction(
+        functions,
         Calculator::Function(
             "log",
             1, // One arg
@@ -946,11 +1429,16 @@ void Calculator::addBasicFunctions()
                 stack.pop_back();
 
                 return std::log(value);
+            },
+            [](const NumberType* const* arguments, NumberType* result, std::size_t count, MathAccuracy accuracy)
+            {
+                VectorMath::log(arguments[0], result, count, accuracy);
             }
         )
     );
 
-    addFunction(
+    insertFunction(
+        functions,
         Calculator::Function(
             "log10",
             1, // One arg
@@ -965,7 +1453,28 @@ void Calculator::addBasicFunctions()
         )
     );
 
-    addFunction(
+    insertFunction(
+        functions,
+        Calculator::Function(
+            "exp",
+            1, // One arg
+            4,
+            [](Calculator::ArgumentsStack& stack) -> NumberType
+            {
+                auto value = stack.back();
+                stack.pop_back();
+
+                return std::exp(value);
+            },
+            [](const NumberType* const* arguments, NumberType* result, std::size_t count, MathAccuracy accuracy)
+            {
+                VectorMath::exp(arguments[0], result, count, accuracy);
+            }
+        )
+    );
+
+    insertFunction(
+        functions,
         Calculator::Function(
             "sqrt",
             1, // One arg
@@ -976,11 +1485,16 @@ void Calculator::addBasicFunctions()
                 stack.pop_back();
 
                 return std::sqrt(value);
+            },
+            [](const NumberType* const* arguments, NumberType* result, std::size_t count, MathAccuracy accuracy)
+            {
+                VectorMath::sqrt(arguments[0], result, count, accuracy);
             }
         )
     );
 
-    addFunction(
+    insertFunction(
+        functions,
         Calculator::Function(
             "ceil",
             1, // One arg
@@ -991,11 +1505,19 @@ void Calculator::addBasicFunctions()
                 stack.pop_back();
 
                 return std::ceil(value);
+            },
+            [](const NumberType* const* arguments, NumberType* result, std::size_t count, MathAccuracy)
+            {
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    result[i] = std::ceil(arguments[0][i]);
+                }
             }
         )
     );
 
-    addFunction(
+    insertFunction(
+        functions,
         Calculator::Function(
             "floor",
             1, // One arg
@@ -1006,11 +1528,19 @@ void Calculator::addBasicFunctions()
                 stack.pop_back();
 
                 return std::floor(value);
+            },
+            [](const NumberType* const* arguments, NumberType* result, std::size_t count, MathAccuracy)
+            {
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    result[i] = std::floor(arguments[0][i]);
+                }
             }
         )
     );
 
-    addFunction(
+    insertFunction(
+        functions,
         Calculator::Function(
             "%",
             2, // Two args
@@ -1029,9 +1559,10 @@ void Calculator::addBasicFunctions()
     );
 }
 
-void Calculator::addLogicFunctions()
+void Calculator::fillLogicFunctions(FunctionTable& functions)
 {
-    addFunction(
+    insertFunction(
+        functions,
         Calculator::Function(
             ">",
             2,
@@ -1049,7 +1580,8 @@ void Calculator::addLogicFunctions()
         )
     );
 
-    addFunction(
+    insertFunction(
+        functions,
         Calculator::Function(
             "<",
             2,
@@ -1067,7 +1599,8 @@ void Calculator::addLogicFunctions()
         )
     );
 
-    addFunction(
+    insertFunction(
+        functions,
         Calculator::Function(
             ">=",
             2,
@@ -1085,7 +1618,8 @@ void Calculator::addLogicFunctions()
         )
     );
 
-    addFunction(
+    insertFunction(
+        functions,
         Calculator::Function(
             "<=",
             2,
@@ -1103,7 +1637,8 @@ void Calculator::addLogicFunctions()
         )
     );
 
-    addFunction(
+    insertFunction(
+        functions,
         Calculator::Function(
             "==",
             2,
@@ -1121,7 +1656,8 @@ void Calculator::addLogicFunctions()
         )
     );
 
-    addFunction(
+    insertFunction(
+        functions,
         Calculator::Function(
             "!=",
             2,
@@ -1139,7 +1675,8 @@ void Calculator::addLogicFunctions()
         )
     );
 
-    addFunction(
+    insertFunction(
+        functions,
         Calculator::Function(
             "if",
             3,
@@ -1163,13 +1700,21 @@ void Calculator::addLogicFunctions()
 
 void Calculator::addConstants()
 {
+    // There are no own constants, so shared
+    // constants are used.
+    if (m_constants.size() == m_constants.sharedSize())
+    {
+        m_constants = SymbolTable<NumberType>(sharedConstants());
+        return;
+    }
+
     addConstant("Pi", M_PI);
     addConstant("e",  M_E);
 }
 
-void Calculator::addConstant(std::string name, NumberType value)
+void Calculator::addConstant(std::string_view name, NumberType value)
 {
-    m_constants[m_stringHash(name)] = value;
+    m_constants.insert(name, value);
 }
 
 std::ostream& operator<<(std::ostream& stream, const Calculator::LexemStack& stack)
@@ -1188,7 +1733,7 @@ std::ostream& operator<<(std::ostream& stream, const Calculator::LexemStack& sta
             stream << 'V' << std::get<std::size_t>(lexem.value);
             break;
         case Calculator::Lexem::Type::Function:
-            stream << std::get<Calculator::Function*>(lexem.value)->name;
+            stream << std::get<const Calculator::Function*>(lexem.value)->name;
             break;
         case Calculator::Lexem::Type::BraceOpen:
             stream << '(';
@@ -1199,9 +1744,15 @@ std::ostream& operator<<(std::ostream& stream, const Calculator::LexemStack& sta
         case Calculator::Lexem::Type::Comma:
             stream << ',';
             break;
+        case Calculator::Lexem::Type::Reduction:
+            stream << 'R' << std::get<std::size_t>(lexem.value);
+            break;
+        case Calculator::Lexem::Type::Parameter:
+            stream << 'P' << std::get<std::size_t>(lexem.value);
+            break;
         }
 
-        std::cout << ' ';
+        stream << ' ';
     }
 
     return stream;
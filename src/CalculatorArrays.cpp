@@ -0,0 +1,335 @@
+#include <algorithm>
+#include <limits>
+#include <StatementException.hpp>
+#include "Calculator.hpp"
+#include "VectorMath.hpp"
+
+namespace
+{
+    // Number of elements, that are computed at once.
+    const std::size_t BlockSize = 256;
+}
+
+Calculator::ReductionType Calculator::getReduction(const Function* function)
+{
+    if (function->function == &Calculator::arraySum)
+    {
+        return ReductionType::Sum;
+    }
+
+    if (function->function == &Calculator::arrayMin)
+    {
+        return ReductionType::Min;
+    }
+
+    if (function->function == &Calculator::arrayMax)
+    {
+        return ReductionType::Max;
+    }
+
+    if (function->function == &Calculator::arrayMean)
+    {
+        return ReductionType::Mean;
+    }
+
+    if (function->function == &Calculator::arrayDot)
+    {
+        return ReductionType::Dot;
+    }
+
+    if (function->function == &Calculator::integrate)
+    {
+        return ReductionType::Integral;
+    }
+
+    return ReductionType::None;
+}
+
+// Reduction functions are never called by execution,
+// because reductions are extracted from expression.
+// Scalar results are reductions of one element array.
+Calculator::NumberType Calculator::arraySum(ArgumentsStack& stack)
+{
+    auto value = stack.back();
+    stack.pop_back();
+
+    return value;
+}
+
+Calculator::NumberType Calculator::arrayMin(ArgumentsStack& stack)
+{
+    return arraySum(stack);
+}
+
+Calculator::NumberType Calculator::arrayMax(ArgumentsStack& stack)
+{
+    return arraySum(stack);
+}
+
+Calculator::NumberType Calculator::arrayMean(ArgumentsStack& stack)
+{
+    return arraySum(stack);
+}
+
+Calculator::NumberType Calculator::arrayDot(ArgumentsStack& stack)
+{
+    auto rhs = stack.back();
+    stack.pop_back();
+
+    auto lhs = stack.back();
+    stack.pop_back();
+
+    return lhs * rhs;
+}
+
+void Calculator::fillArrayFunctions(FunctionTable& functions)
+{
+    insertFunction(functions, Calculator::Function("sum",  1, 4, &Calculator::arraySum));
+    insertFunction(functions, Calculator::Function("amin", 1, 4, &Calculator::arrayMin));
+    insertFunction(functions, Calculator::Function("amax", 1, 4, &Calculator::arrayMax));
+    insertFunction(functions, Calculator::Function("mean", 1, 4, &Calculator::arrayMean));
+    insertFunction(functions, Calculator::Function("dot",  2, 4, &Calculator::arrayDot));
+}
+
+void Calculator::setArray(std::string_view name, std::vector<NumberType> values)
+{
+    auto& variable = m_variables[m_variables.intern(name)];
+
+    variable.value = std::numeric_limits<NumberType>::quiet_NaN();
+    variable.defined = true;
+    variable.array = true;
+    variable.elements = std::move(values);
+}
+
+void Calculator::extractReductions()
+{
+    auto hasReductions = std::any_of(
+        m_expression.begin(),
+        m_expression.end(),
+        [](const Lexem& lexem)
+        {
+            return lexem.type == Lexem::Type::Function &&
+                   getReduction(std::get<const Function*>(lexem.value)) != ReductionType::None;
+        }
+    );
+
+    if (!hasReductions)
+    {
+        return;
+    }
+
+    LexemStack result;
+    result.reserve(m_expression.size());
+
+    for (auto&& lexem : m_expression)
+    {
+        if (lexem.type != Lexem::Type::Function)
+        {
+            result.push_back(lexem);
+            continue;
+        }
+
+        auto function = std::get<const Function*>(lexem.value);
+        auto type = getReduction(function);
+
+        if (type == ReductionType::None)
+        {
+            result.push_back(lexem);
+            continue;
+        }
+
+        Reduction reduction = {};
+        reduction.type = type;
+        reduction.function = function;
+        reduction.arguments.resize(function->numberOfArguments);
+
+        // Arguments are found from last one
+        auto end = result.size();
+
+        for (auto argument = reduction.arguments.rbegin();
+             argument != reduction.arguments.rend();
+             ++argument)
+        {
+            auto begin = argumentStart(result, end);
+
+            argument->assign(result.begin() + begin, result.begin() + end);
+
+            end = begin;
+        }
+
+        for (auto&& argument : reduction.arguments)
+        {
+            for (auto&& value : argument)
+            {
+                // Reductions are computed once per execution
+                // for all elements, so call sites of stateful
+                // functions would have no own states.
+                if (value.type == Lexem::Type::Function &&
+                    isStream(std::get<const Function*>(value.value)))
+                {
+                    throw StatementException(
+                        std::string("Stateful function \"")
+                            .append(std::get<const Function*>(value.value)->name)
+                            .append("\" can't be used in \"")
+                            .append(function->name)
+                            .append("\"")
+                    );
+                }
+
+                if (value.type == Lexem::Type::Variable)
+                {
+                    reduction.variables.push_back(std::get<std::size_t>(value.value));
+                }
+                else if (value.type == Lexem::Type::Reduction)
+                {
+                    // Nested reductions are computed before
+                    auto& nested = m_reductions[std::get<std::size_t>(value.value)];
+
+                    reduction.variables.insert(
+                        reduction.variables.end(),
+                        nested.variables.begin(),
+                        nested.variables.end()
+                    );
+                }
+            }
+        }
+
+        if (type == ReductionType::Integral)
+        {
+            extractIntegral(reduction);
+        }
+
+        result.resize(end);
+        result.emplace_back(Lexem::Type::Reduction, m_reductions.size());
+
+        m_reductions.emplace_back(std::move(reduction));
+    }
+
+    m_expression = std::move(result);
+}
+
+bool Calculator::computeReductions()
+{
+    if (m_reductions.empty())
+    {
+        return true;
+    }
+
+    m_reductionColumns.assign(m_variables.size(), nullptr);
+
+    for (auto&& reduction : m_reductions)
+    {
+        if (reduction.type == ReductionType::Integral)
+        {
+            reduction.value = computeIntegral(reduction);
+            continue;
+        }
+
+        // Length of arrays. Scalar arguments
+        // are reduced as one element arrays.
+        std::size_t length = 1;
+        auto hasArrays = false;
+
+        for (auto slot : reduction.variables)
+        {
+            auto& variable = m_variables[slot];
+
+            if (!variable.array)
+            {
+                continue;
+            }
+
+            if (hasArrays && variable.elements.size() != length)
+            {
+                return false;
+            }
+
+            length = variable.elements.size();
+            hasArrays = true;
+
+            m_reductionColumns[slot] = variable.elements.data();
+        }
+
+        NumberType result = 0;
+
+        if (reduction.type == ReductionType::Min)
+        {
+            result = std::numeric_limits<NumberType>::infinity();
+        }
+        else if (reduction.type == ReductionType::Max)
+        {
+            result = -std::numeric_limits<NumberType>::infinity();
+        }
+
+        std::size_t depth = 0;
+
+        for (auto&& argument : reduction.arguments)
+        {
+            depth = std::max(depth, stackDepth(argument));
+        }
+
+        m_batchWorkspace.stack.resize(depth * BlockSize);
+
+        for (std::size_t offset = 0; offset < length; offset += BlockSize)
+        {
+            auto count = std::min(BlockSize, length - offset);
+
+            if (reduction.type == ReductionType::Dot)
+            {
+                computeBlock(reduction.arguments[0], m_reductionColumns.data(), offset, count, nullptr);
+
+                m_reductionBuffer.assign(m_batchWorkspace.stack.data(), m_batchWorkspace.stack.data() + count);
+
+                computeBlock(reduction.arguments[1], m_reductionColumns.data(), offset, count, nullptr);
+
+                result += VectorMath::dot(m_reductionBuffer.data(), m_batchWorkspace.stack.data(), count);
+
+                continue;
+            }
+
+            computeBlock(reduction.arguments[0], m_reductionColumns.data(), offset, count, nullptr);
+
+            switch (reduction.type)
+            {
+            case ReductionType::Min:
+                result = std::min(result, VectorMath::min(m_batchWorkspace.stack.data(), count));
+                break;
+            case ReductionType::Max:
+                result = std::max(result, VectorMath::max(m_batchWorkspace.stack.data(), count));
+                break;
+            default:
+                result += VectorMath::sum(m_batchWorkspace.stack.data(), count);
+                break;
+            }
+        }
+
+        switch (reduction.type)
+        {
+        case ReductionType::Min:
+        case ReductionType::Max:
+            if (length == 0)
+            {
+                result = std::numeric_limits<NumberType>::quiet_NaN();
+            }
+            break;
+
+        case ReductionType::Mean:
+            result = (length == 0) ?
+                std::numeric_limits<NumberType>::quiet_NaN() :
+                result / length;
+            break;
+
+        default:
+            break;
+        }
+
+        reduction.value = result;
+
+        for (auto slot : reduction.variables)
+        {
+            m_reductionColumns[slot] = nullptr;
+        }
+    }
+
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,353 @@
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include "Calculator.hpp"
+
+namespace
+{
+    // Number of rows, that are computed at once.
+    // Block of every stack level fits L1 cache.
+    const std::size_t BlockSize = 256;
+}
+
+void Calculator::setMathAccuracy(MathAccuracy accuracy)
+{
+    m_mathAccuracy = accuracy;
+}
+
+MathAccuracy Calculator::getMathAccuracy() const
+{
+    return m_mathAccuracy;
+}
+
+void Calculator::executeBatch(const std::vector<BatchColumn>& columns,
+                              std::size_t rows,
+                              NumberType* results)
+{
+    std::size_t undefinedSlot = m_variables.npos;
+
+    switch (computeBatch(columns, rows, results, nullptr, undefinedSlot))
+    {
+    case ExecutionStatus::UndefinedVariable:
+        throw CalculationException(
+            std::string("No variable \"")
+                .append(m_variables.name(undefinedSlot))
+                .append("\" defined")
+        );
+
+    case ExecutionStatus::UnbalancedExpression:
+        throw StatementException("Unbalanced expression");
+
+    case ExecutionStatus::ArraySizeMismatch:
+        throw CalculationException("Arrays in reduction have different sizes");
+
+    default:
+        break;
+    }
+}
+
+Calculator::ExecutionStatus Calculator::tryExecuteBatch(const std::vector<BatchColumn>& columns,
+                                                        std::size_t rows,
+                                                        NumberType* results,
+                                                        uint64_t* errors)
+{
+    std::size_t undefinedSlot = m_variables.npos;
+
+    std::fill(errors, errors + (rows + 63) / 64, 0);
+
+    return computeBatch(columns, rows, results, errors, undefinedSlot);
+}
+
+Calculator::ExecutionStatus Calculator::computeBatch(const std::vector<BatchColumn>& columns,
+                                                     std::size_t rows,
+                                                     NumberType* results,
+                                                     uint64_t* errors,
+                                                     std::size_t& undefinedSlot)
+{
+    if (m_expression.empty())
+    {
+        return ExecutionStatus::UnbalancedExpression;
+    }
+
+    // Columns by variable slots
+    std::vector<const NumberType*> variableColumns(m_variables.size(), nullptr);
+
+    for (auto&& column : columns)
+    {
+        auto slot = m_variables.find(column.variable);
+
+        // Variable is not used by expression
+        if (slot == m_variables.npos)
+        {
+            continue;
+        }
+
+        variableColumns[slot] = column.values;
+    }
+
+    provideVariables(m_referencedVariables, variableColumns.data());
+
+    for (auto slot : m_programVariables)
+    {
+        if (!variableColumns[slot] &&
+            !m_variables[slot].defined &&
+            !m_variables[slot].provided)
+        {
+            undefinedSlot = slot;
+            return ExecutionStatus::UndefinedVariable;
+        }
+    }
+
+    if (!computeReductions())
+    {
+        return ExecutionStatus::ArraySizeMismatch;
+    }
+
+    m_batchWorkspace.stack.resize(stackDepth(m_expression) * BlockSize);
+
+    for (std::size_t offset = 0; offset < rows; offset += BlockSize)
+    {
+        auto count = std::min(BlockSize, rows - offset);
+
+        if (computeBlock(m_expression, variableColumns.data(), offset, count, errors) != 1) // Result
+        {
+            return ExecutionStatus::UnbalancedExpression;
+        }
+
+        std::copy(m_batchWorkspace.stack.data(), m_batchWorkspace.stack.data() + count, results + offset);
+
+        if (errors)
+        {
+            for (std::size_t row = offset; row < offset + count; ++row)
+            {
+                auto& word = errors[row / 64];
+                auto bit = uint64_t(1) << (row % 64);
+
+                if (std::isnan(results[row]))
+                {
+                    word |= bit;
+                }
+                else if (word & bit)
+                {
+                    // Error value was dropped by expression
+                    results[row] = std::numeric_limits<NumberType>::quiet_NaN();
+                }
+            }
+        }
+    }
+
+    return ExecutionStatus::Success;
+}
+
+std::size_t Calculator::computeBlock(const LexemStack& expression,
+                                     const NumberType* const* columns,
+                                     std::size_t offset,
+                                     std::size_t count,
+                                     uint64_t* errors)
+{
+    return computeBlock(expression, columns, offset, count, errors, m_batchWorkspace);
+}
+
+std::size_t Calculator::computeBlock(const LexemStack& expression,
+                                     const NumberType* const* columns,
+                                     std::size_t offset,
+                                     std::size_t count,
+                                     uint64_t* errors,
+                                     BatchWorkspace& workspace,
+                                     std::size_t derivativeSlot) const
+{
+    auto derivatives = (derivativeSlot != m_variables.npos);
+
+    std::size_t depth = 0;
+
+    for (auto&& lexem : expression)
+    {
+        auto block = workspace.stack.data() + depth * BlockSize;
+
+        // Derivatives of values are zeros, except
+        // for the variable itself.
+        if (derivatives && lexem.type != Lexem::Type::Function)
+        {
+            auto derivative = workspace.derivatives.data() + depth * BlockSize;
+
+            std::fill(
+                derivative,
+                derivative + count,
+                (lexem.type == Lexem::Type::Variable &&
+                 std::get<std::size_t>(lexem.value) == derivativeSlot) ? 1 : 0
+            );
+        }
+
+        switch (lexem.type)
+        {
+        case Lexem::Type::Constant:
+            std::fill(block, block + count, std::get<NumberType>(lexem.value));
+
+            ++depth;
+            break;
+
+        case Lexem::Type::Variable:
+        {
+            auto slot = std::get<std::size_t>(lexem.value);
+
+            if (columns[slot])
+            {
+                std::copy(
+                    columns[slot] + offset,
+                    columns[slot] + offset + count,
+                    block
+                );
+            }
+            else
+            {
+                std::fill(block, block + count, m_variables[slot].value);
+            }
+
+            ++depth;
+            break;
+        }
+
+        case Lexem::Type::Reduction:
+            std::fill(block, block + count, m_reductions[std::get<std::size_t>(lexem.value)].value);
+
+            ++depth;
+            break;
+
+        case Lexem::Type::Function:
+        {
+            auto function = std::get<const Function*>(lexem.value);
+
+            depth -= function->numberOfArguments;
+
+            if (derivatives)
+            {
+                differentiate(
+                    function,
+                    workspace.stack.data() + depth * BlockSize,
+                    workspace.derivatives.data() + depth * BlockSize,
+                    count
+                );
+            }
+
+            computeFunction(
+                function,
+                workspace.stack.data() + depth * BlockSize,
+                offset,
+                count,
+                errors,
+                workspace
+            );
+
+            ++depth;
+            break;
+        }
+
+        default:
+            throw StatementException("Unexpected lexem detected");
+        }
+    }
+
+    return depth;
+}
+
+void Calculator::computeFunction(const Function* function,
+                                 NumberType* block,
+                                 std::size_t offset,
+                                 std::size_t count,
+                                 uint64_t* errors,
+                                 BatchWorkspace& workspace) const
+{
+    workspace.arguments.clear();
+
+    for (uint32_t i = 0; i < function->numberOfArguments; ++i)
+    {
+        workspace.arguments.push_back(block + i * BlockSize);
+    }
+
+    if (function->batch)
+    {
+        function->batch(workspace.arguments.data(), block, count, m_mathAccuracy);
+        return;
+    }
+
+    // Row by row fallback
+    for (std::size_t row = 0; row < count; ++row)
+    {
+        workspace.values.clear();
+
+        for (auto&& argument : workspace.arguments)
+        {
+            workspace.values.push_back(argument[row]);
+        }
+
+        if (!errors)
+        {
+            block[row] = function->call(workspace.values);
+            continue;
+        }
+
+        try
+        {
+            block[row] = function->call(workspace.values);
+        }
+        catch (std::exception&)
+        {
+            block[row] = std::numeric_limits<NumberType>::quiet_NaN();
+            errors[(offset + row) / 64] |= uint64_t(1) << ((offset + row) % 64);
+        }
+    }
+}
+
+void Calculator::runParallel(std::size_t threads,
+                             std::size_t tasks,
+                             const std::function<void()>& worker)
+{
+    if (threads == 0)
+    {
+        threads = std::max(1U, std::thread::hardware_concurrency());
+    }
+
+    threads = std::max<std::size_t>(1, std::min(threads, tasks));
+
+    std::mutex failureMutex;
+    std::exception_ptr failure;
+
+    auto run = [&]()
+    {
+        try
+        {
+            worker();
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(failureMutex);
+
+            if (!failure)
+            {
+                failure = std::current_exception();
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+
+    for (std::size_t i = 1; i < threads; ++i)
+    {
+        workers.emplace_back(run);
+    }
+
+    run();
+
+    for (auto&& thread : workers)
+    {
+        thread.join();
+    }
+
+    if (failure)
+    {
+        std::rethrow_exception(failure);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,141 @@
+#include <algorithm>
+#include <StatementException.hpp>
+#include "Calculator.hpp"
+
+Calculator::NumberType Calculator::inlinedFunction(ArgumentsStack& /* stack */)
+{
+    throw StatementException("User-defined function is not inlined");
+}
+
+std::size_t Calculator::argumentStart(const LexemStack& expression, std::size_t end)
+{
+    // Argument starts, when it has no missing values
+    std::size_t needed = 1;
+
+    while (needed > 0)
+    {
+        auto& lexem = expression[--end];
+
+        if (lexem.type == Lexem::Type::Function)
+        {
+            needed += std::get<const Function*>(lexem.value)->numberOfArguments;
+        }
+
+        --needed;
+    }
+
+    return end;
+}
+
+void Calculator::defineFunction(std::string_view name,
+                                const std::vector<std::string>& parameters,
+                                std::string_view body)
+{
+    // Compiled expression is kept
+    LexemStack expression;
+    std::swap(expression, m_expression);
+
+    m_parameters = &parameters;
+
+    try
+    {
+        LexemBuffer lexems(&m_compileArena);
+
+        splitOnLexems(body, lexems);
+        pushLexems(lexems);
+        performValidation();
+
+        // Body contains only native functions,
+        // so inlining is not recursive.
+        inlineFunctions();
+    }
+    catch (...)
+    {
+        m_parameters = nullptr;
+        std::swap(expression, m_expression);
+        throw;
+    }
+
+    m_parameters = nullptr;
+    std::swap(expression, m_expression);
+
+    Calculator::Function function(
+        std::string(name),
+        static_cast<uint32_t>(parameters.size()),
+        4,
+        &Calculator::inlinedFunction
+    );
+
+    function.body = std::move(expression);
+
+    addFunction(std::move(function));
+}
+
+void Calculator::inlineFunctions()
+{
+    auto hasCalls = std::any_of(
+        m_expression.begin(),
+        m_expression.end(),
+        [](const Lexem& lexem)
+        {
+            return lexem.type == Lexem::Type::Function &&
+                   !std::get<const Function*>(lexem.value)->body.empty();
+        }
+    );
+
+    if (!hasCalls)
+    {
+        return;
+    }
+
+    LexemStack result;
+    result.reserve(m_expression.size());
+
+    std::vector<LexemStack> arguments;
+
+    for (auto&& lexem : m_expression)
+    {
+        if (lexem.type != Lexem::Type::Function ||
+            std::get<const Function*>(lexem.value)->body.empty())
+        {
+            result.push_back(lexem);
+            continue;
+        }
+
+        auto function = std::get<const Function*>(lexem.value);
+
+        arguments.resize(function->numberOfArguments);
+
+        // Arguments are found from last one
+        auto end = result.size();
+
+        for (auto argument = arguments.rbegin();
+             argument != arguments.rend();
+             ++argument)
+        {
+            auto begin = argumentStart(result, end);
+
+            argument->assign(result.begin() + begin, result.begin() + end);
+
+            end = begin;
+        }
+
+        result.resize(end);
+
+        // Parameters are replaced with argument RPN
+        for (auto&& bodyLexem : function->body)
+        {
+            if (bodyLexem.type != Lexem::Type::Parameter)
+            {
+                result.push_back(bodyLexem);
+                continue;
+            }
+
+            auto& argument = arguments[std::get<std::size_t>(bodyLexem.value)];
+
+            result.insert(result.end(), argument.begin(), argument.end());
+        }
+    }
+
+    m_expression = std::move(result);
+}
\ No newline at end of file
@@ -0,0 +1,344 @@
+#include <algorithm>
+#include <cmath>
+#include "Calculator.hpp"
+
+namespace
+{
+    // Polynomials up to this degree are computed
+    // with Horner's scheme.
+    const std::size_t HornerDegree = 4;
+
+    // Minimal number of lexems, that are replaced
+    // by polynomial without powers.
+    const std::size_t MinLength = 5;
+
+    const std::size_t NoVariable = static_cast<std::size_t>(-1);
+}
+
+std::size_t Calculator::detectPolynomials()
+{
+    // Value, that's computed by lexems of result
+    // from `begin` up to next value. Terms are
+    // temporaries, so they are allocated from arena.
+    struct Term
+    {
+        Term(std::size_t termBegin,
+             bool termPolynomial,
+             std::size_t termVariable,
+             std::initializer_list<NumberType> termCoefficients,
+             std::pmr::memory_resource* resource) :
+            begin(termBegin),
+            polynomial(termPolynomial),
+            variable(termVariable),
+            powers(false),
+            coefficients(termCoefficients, resource)
+        {
+
+        }
+
+        std::size_t begin;
+
+        // Is value polynomial in one variable.
+        bool polynomial;
+
+        // Variable slot of polynomial. Polynomials
+        // without variable are constants.
+        std::size_t variable;
+
+        // Is value computed with `^`.
+        bool powers;
+
+        std::pmr::vector<NumberType> coefficients;
+    };
+
+    LexemBuffer result(&m_compileArena);
+    result.reserve(m_expression.size());
+
+    std::pmr::vector<Term> terms(&m_compileArena);
+
+    std::size_t count = 0;
+
+    // Replacing lexems of term with polynomial lexem
+    auto compress = [&](std::size_t index)
+    {
+        auto& term = terms[index];
+
+        auto end = (index + 1 < terms.size()) ? terms[index + 1].begin : result.size();
+
+        if (!term.polynomial ||
+            term.variable == NoVariable ||
+            term.coefficients.size() < 3 ||
+            (!term.powers && end - term.begin < MinLength))
+        {
+            return;
+        }
+
+        m_polynomials.emplace_back();
+
+        auto& polynomial = m_polynomials.back();
+
+        std::copy(term.coefficients.begin(), term.coefficients.end(), polynomial.coefficients.begin());
+        polynomial.count = term.coefficients.size();
+        polynomial.function = Calculator::Function(
+            "poly",
+            1,
+            4,
+            &Calculator::evaluatePolynomial,
+            &polynomial
+        );
+
+        // Polynomial is put in place of term, so
+        // order of operands is kept.
+        auto position = result.erase(
+            result.begin() + static_cast<std::ptrdiff_t>(term.begin),
+            result.begin() + static_cast<std::ptrdiff_t>(end)
+        );
+
+        position = result.insert(position, Lexem(Lexem::Type::Variable, term.variable));
+        result.insert(position + 1, Lexem(Lexem::Type::Function, &polynomial.function));
+
+        for (auto next = index + 1; next < terms.size(); ++next)
+        {
+            terms[next].begin = terms[next].begin + 2 - (end - term.begin);
+        }
+
+        term.polynomial = false;
+
+        ++count;
+    };
+
+    // Is term a constant times power of variable.
+    auto isMonomial = [](const Term& term)
+    {
+        return std::count_if(
+            term.coefficients.begin(),
+            term.coefficients.end(),
+            [](NumberType coefficient) { return coefficient != 0; }
+        ) <= 1;
+    };
+
+    // Combining polynomials with built-in operator. Only
+    // sums of monomials are collected: expanded products
+    // and powers of sums, like `(x - 1000) ^ 4`, lose
+    // precision near roots due to cancellation.
+    auto combine = [&isMonomial](const Term& lhs, const Term& rhs, Operation operation, Term& combined)
+    {
+        if (!lhs.polynomial ||
+            !rhs.polynomial ||
+            (lhs.variable != NoVariable &&
+             rhs.variable != NoVariable &&
+             lhs.variable != rhs.variable))
+        {
+            return;
+        }
+
+        auto& a = lhs.coefficients;
+        auto& b = rhs.coefficients;
+
+        auto& c = combined.coefficients;
+
+        auto lhsConstant = (lhs.variable == NoVariable);
+        auto rhsConstant = (rhs.variable == NoVariable);
+
+        switch (operation)
+        {
+        case Operation::Add:
+        case Operation::Subtract:
+            c.assign(std::max(a.size(), b.size()), 0);
+
+            for (std::size_t i = 0; i < a.size(); ++i)
+            {
+                c[i] = a[i];
+            }
+
+            for (std::size_t i = 0; i < b.size(); ++i)
+            {
+                c[i] += (operation == Operation::Add) ? b[i] : -b[i];
+            }
+            break;
+
+        case Operation::Multiply:
+            if ((!lhsConstant && !rhsConstant && (!isMonomial(lhs) || !isMonomial(rhs))) ||
+                a.size() + b.size() - 2 > Polynomial::MaxDegree)
+            {
+                return;
+            }
+
+            c.assign(a.size() + b.size() - 1, 0);
+
+            for (std::size_t i = 0; i < a.size(); ++i)
+            {
+                for (std::size_t j = 0; j < b.size(); ++j)
+                {
+                    c[i + j] += a[i] * b[j];
+                }
+            }
+            break;
+
+        case Operation::Divide:
+            if (!rhsConstant || b[0] == 0)
+            {
+                return;
+            }
+
+            c = a;
+
+            for (auto&& coefficient : c)
+            {
+                coefficient /= b[0];
+            }
+            break;
+
+        case Operation::Power:
+        {
+            // Only small natural powers of monomials
+            if (!rhsConstant ||
+                !isMonomial(lhs) ||
+                !(b[0] >= 0) ||
+                b[0] > Polynomial::MaxDegree ||
+                b[0] != std::floor(b[0]) ||
+                (a.size() - 1) * b[0] > Polynomial::MaxDegree)
+            {
+                return;
+            }
+
+            c.assign(1, 1);
+
+            for (auto i = static_cast<std::size_t>(b[0]); i > 0; --i)
+            {
+                std::pmr::vector<NumberType> product(c.size() + a.size() - 1, 0, c.get_allocator());
+
+                for (std::size_t j = 0; j < c.size(); ++j)
+                {
+                    for (std::size_t k = 0; k < a.size(); ++k)
+                    {
+                        product[j + k] += c[j] * a[k];
+                    }
+                }
+
+                c = std::move(product);
+            }
+
+            combined.powers = true;
+            break;
+        }
+
+        default:
+            return;
+        }
+
+        combined.polynomial = true;
+        combined.variable = (lhs.variable != NoVariable) ? lhs.variable : rhs.variable;
+        combined.powers = combined.powers || lhs.powers || rhs.powers;
+    };
+
+    for (auto&& lexem : m_expression)
+    {
+        switch (lexem.type)
+        {
+        case Lexem::Type::Constant:
+            terms.emplace_back(result.size(), true, NoVariable, std::initializer_list<NumberType>{std::get<NumberType>(lexem.value)}, &m_compileArena);
+            break;
+
+        case Lexem::Type::Variable:
+            terms.emplace_back(result.size(), true, std::get<std::size_t>(lexem.value), std::initializer_list<NumberType>{0, 1}, &m_compileArena);
+            break;
+
+        case Lexem::Type::Function:
+        {
+            auto function = std::get<const Function*>(lexem.value);
+            auto first = terms.size() - function->numberOfArguments;
+
+            Term combined(result.size(), false, NoVariable, {}, &m_compileArena);
+
+            if (function->numberOfArguments > 0)
+            {
+                combined.begin = terms[first].begin;
+            }
+
+            if (function->numberOfArguments == 2)
+            {
+                combine(terms[first], terms[first + 1], getOperation(function), combined);
+            }
+
+            // Arguments are not extended, so polynomials
+            // end here. Last ones go first, so positions
+            // of previous ones are kept.
+            if (!combined.polynomial)
+            {
+                for (auto index = terms.size(); index-- > first;)
+                {
+                    compress(index);
+                }
+            }
+
+            terms.erase(terms.begin() + static_cast<std::ptrdiff_t>(first), terms.end());
+            terms.push_back(std::move(combined));
+            break;
+        }
+
+        default:
+            terms.emplace_back(result.size(), false, NoVariable, std::initializer_list<NumberType>{}, &m_compileArena);
+            break;
+        }
+
+        // Function lexem is kept, even if arguments are
+        // compressed. Polynomial itself is compressed later.
+        result.push_back(lexem);
+    }
+
+    for (auto index = terms.size(); index-- > 0;)
+    {
+        compress(index);
+    }
+
+    m_expression.assign(result.begin(), result.end());
+
+    return count;
+}
+
+Calculator::NumberType Calculator::evaluatePolynomial(ArgumentsStack& stack, void* context)
+{
+    auto x = stack.back();
+    stack.pop_back();
+
+    auto polynomial = static_cast<const Polynomial*>(context);
+    auto& coefficients = polynomial->coefficients;
+
+    auto count = polynomial->count;
+
+    // Multiply-add chains are contracted into
+    // FMA, if target supports it.
+    if (count <= HornerDegree + 1)
+    {
+        auto result = coefficients[count - 1];
+
+        for (auto i = count - 1; i-- > 0;)
+        {
+            result = result * x + coefficients[i];
+        }
+
+        return result;
+    }
+
+    // Estrin's scheme. Pairs of terms are
+    // independent, so they are computed in parallel.
+    auto terms = coefficients;
+
+    auto power = x;
+
+    while (count > 1)
+    {
+        for (std::size_t i = 0; 2 * i < count; ++i)
+        {
+            terms[i] = (2 * i + 1 < count) ?
+                terms[2 * i + 1] * power + terms[2 * i] :
+                terms[2 * i];
+        }
+
+        count = (count + 1) / 2;
+        power *= power;
+    }
+
+    return terms[0];
+}
\ No newline at end of file
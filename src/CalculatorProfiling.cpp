@@ -0,0 +1,146 @@
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+#include "Calculator.hpp"
+
+void Calculator::setProfiling(bool enabled)
+{
+    m_profiling = enabled;
+
+    resetProfile();
+}
+
+void Calculator::resetProfile()
+{
+    m_profiledExecutions = 0;
+
+    m_profile.assign(
+        m_profiling ? m_expression.size() : 0,
+        ProfileEntry()
+    );
+}
+
+Calculator::ExecutionProfile Calculator::getProfile() const
+{
+    ExecutionProfile profile;
+
+    profile.executions = m_profiledExecutions;
+    profile.positions = m_profile;
+
+    for (std::size_t position = 0; position < m_profile.size(); ++position)
+    {
+        auto& lexem = m_expression[position];
+
+        if (lexem.type != Lexem::Type::Function)
+        {
+            continue;
+        }
+
+        auto& entry = profile.functions[std::get<const Function*>(lexem.value)->name];
+
+        entry.calls += m_profile[position].calls;
+        entry.time += m_profile[position].time;
+    }
+
+    return profile;
+}
+
+void Calculator::printProfile(std::ostream& stream) const
+{
+    auto profile = getProfile();
+
+    std::chrono::nanoseconds total(0);
+
+    for (auto&& entry : profile.positions)
+    {
+        total += entry.time;
+    }
+
+    auto share = [&total](std::chrono::nanoseconds time)
+    {
+        return total.count() ? 100.0 * time.count() / total.count() : 0.0;
+    };
+
+    stream << "Executions: " << profile.executions << std::endl
+           << "Total time: " << total.count() << " ns" << std::endl
+           << std::endl;
+
+    stream << std::left
+           << std::setw(6)  << "#"
+           << std::setw(24) << "Lexem"
+           << std::setw(12) << "Calls"
+           << std::setw(16) << "Time, ns"
+           << std::setw(12) << "Avg, ns"
+           << "Share, %" << std::endl;
+
+    for (std::size_t position = 0; position < profile.positions.size(); ++position)
+    {
+        auto& lexem = m_expression[position];
+        auto& entry = profile.positions[position];
+
+        std::stringstream name;
+
+        switch (lexem.type)
+        {
+        case Lexem::Type::Constant:
+            name << std::get<NumberType>(lexem.value);
+            break;
+        case Lexem::Type::Variable:
+            name << m_variables.name(std::get<std::size_t>(lexem.value));
+            break;
+        case Lexem::Type::Function:
+            name << std::get<const Function*>(lexem.value)->name << "()";
+            break;
+        case Lexem::Type::Reduction:
+            name << m_reductions[std::get<std::size_t>(lexem.value)].function->name << "()";
+            break;
+        default:
+            name << "???";
+            break;
+        }
+
+        stream << std::setw(6)  << position
+               << std::setw(24) << name.str()
+               << std::setw(12) << entry.calls
+               << std::setw(16) << entry.time.count()
+               << std::setw(12) << (entry.calls ? entry.time.count() / entry.calls : 0)
+               << std::fixed << std::setprecision(2) << share(entry.time)
+               << std::defaultfloat << std::endl;
+    }
+
+    std::vector<std::pair<std::string, ProfileEntry>> functions(
+        profile.functions.begin(),
+        profile.functions.end()
+    );
+
+    std::stable_sort(
+        functions.begin(),
+        functions.end(),
+        [](const auto& lhs, const auto& rhs)
+        {
+            return lhs.second.time > rhs.second.time;
+        }
+    );
+
+    stream << std::endl
+           << std::setw(30) << "Function"
+           << std::setw(12) << "Calls"
+           << std::setw(16) << "Time, ns"
+           << std::setw(12) << "Avg, ns"
+           << "Share, %" << std::endl;
+
+    for (auto&& function : functions)
+    {
+        auto& entry = function.second;
+
+        stream << std::setw(30) << function.first
+               << std::setw(12) << entry.calls
+               << std::setw(16) << entry.time.count()
+               << std::setw(12) << (entry.calls ? entry.time.count() / entry.calls : 0)
+               << std::fixed << std::setprecision(2) << share(entry.time)
+               << std::defaultfloat << std::endl;
+    }
+
+    stream << std::right;
+}
\ No newline at end of file
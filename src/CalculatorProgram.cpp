@@ -0,0 +1,511 @@
+#include <algorithm>
+#include <cmath>
+#include "Calculator.hpp"
+
+Calculator::Operation Calculator::getOperation(const Function* function)
+{
+    if (function->function == &Calculator::add)
+    {
+        return Operation::Add;
+    }
+
+    if (function->function == &Calculator::subtract)
+    {
+        return Operation::Subtract;
+    }
+
+    if (function->function == &Calculator::multiply)
+    {
+        return Operation::Multiply;
+    }
+
+    if (function->function == &Calculator::divide)
+    {
+        return Operation::Divide;
+    }
+
+    if (function->function == &Calculator::power)
+    {
+        return Operation::Power;
+    }
+
+    return Operation::None;
+}
+
+Calculator::NumberType Calculator::operate(Operation operation, NumberType lhs, NumberType rhs)
+{
+    switch (operation)
+    {
+    case Operation::Add:
+        return lhs + rhs;
+    case Operation::Subtract:
+        return lhs - rhs;
+    case Operation::Multiply:
+        return lhs * rhs;
+    case Operation::Divide:
+        return lhs / rhs;
+    case Operation::Power:
+        return std::pow(lhs, rhs);
+    default:
+        return 0;
+    }
+}
+
+void Calculator::setBackend(Backend backend)
+{
+    m_backend = backend;
+
+    if (!m_expression.empty())
+    {
+        buildProgram();
+    }
+}
+
+Calculator::Backend Calculator::getBackend() const
+{
+    return m_backend;
+}
+
+void Calculator::clearExpression()
+{
+    m_expression.clear();
+    m_program.clear();
+    m_programThreaded = false;
+    m_registerProgram.clear();
+    m_registerResult = nullptr;
+    m_programVariables.clear();
+    m_referencedVariables.clear();
+    m_reductions.clear();
+    m_polynomials.clear();
+    m_streams.clear();
+    m_generalExpression.clear();
+}
+
+void Calculator::buildProgram()
+{
+    m_program.clear();
+    m_programThreaded = false;
+    m_registerProgram.clear();
+    m_registerSources.clear();
+    m_registerResult = nullptr;
+    m_programConstants.clear();
+    m_programVariables.clear();
+
+    // Constants are referenced by pointers,
+    // so pool must not be reallocated.
+    m_programConstants.reserve(m_expression.size());
+
+    switch (m_backend)
+    {
+    case Backend::Stack:
+        buildStackProgram();
+        break;
+    case Backend::Register:
+        buildRegisterProgram();
+        break;
+    }
+
+    for (auto&& reduction : m_reductions)
+    {
+        m_programVariables.insert(
+            m_programVariables.end(),
+            reduction.variables.begin(),
+            reduction.variables.end()
+        );
+    }
+
+    std::sort(m_programVariables.begin(), m_programVariables.end());
+
+    m_programVariables.erase(
+        std::unique(m_programVariables.begin(), m_programVariables.end()),
+        m_programVariables.end()
+    );
+
+    // Reductions are computed before expression
+    m_referencedVariables.clear();
+
+    auto reference = [this](std::size_t slot)
+    {
+        if (std::find(m_referencedVariables.begin(), m_referencedVariables.end(), slot) == m_referencedVariables.end())
+        {
+            m_referencedVariables.push_back(slot);
+        }
+    };
+
+    for (auto&& reduction : m_reductions)
+    {
+        std::for_each(reduction.variables.begin(), reduction.variables.end(), reference);
+    }
+
+    for (auto&& lexem : m_expression)
+    {
+        if (lexem.type == Lexem::Type::Variable)
+        {
+            reference(std::get<std::size_t>(lexem.value));
+        }
+    }
+
+    // Requests are not allocated on execution
+    m_variableRequests.reserve(m_referencedVariables.size());
+    m_requestedSlots.reserve(m_referencedVariables.size());
+
+    m_executionStack.reserve(stackDepth(m_expression));
+}
+
+const Calculator::NumberType* Calculator::programValue(const Lexem& lexem)
+{
+    if (lexem.type == Lexem::Type::Constant)
+    {
+        m_programConstants.push_back(std::get<NumberType>(lexem.value));
+
+        return &m_programConstants.back();
+    }
+
+    if (lexem.type == Lexem::Type::Reduction)
+    {
+        return &m_reductions[std::get<std::size_t>(lexem.value)].value;
+    }
+
+    auto slot = std::get<std::size_t>(lexem.value);
+
+    m_programVariables.push_back(slot);
+
+    return &m_variables[slot].value;
+}
+
+void Calculator::buildStackProgram()
+{
+    // Kinds of fused lexems
+    enum class Operand
+    {
+        Value,    // Constant, variable or reduction
+        Operator, // Built-in arithmetic operator
+        Unary,    // Function with one argument
+        Function  // Any function
+    };
+
+    struct FusionRule
+    {
+        std::size_t length;
+        Operand pattern[3];
+        Instruction::Code code;
+    };
+
+    // Rules are tried in order, so longer
+    // patterns have to go first. Operator rules
+    // contain code of `Operation::Add`.
+    static const FusionRule rules[] = {
+        {3, {Operand::Value, Operand::Value, Operand::Operator}, Instruction::Code::PushPushAdd},
+        {2, {Operand::Value, Operand::Operator},                 Instruction::Code::PushAdd},
+        {2, {Operand::Value, Operand::Unary},                    Instruction::Code::PushCall},
+        {1, {Operand::Value},                                    Instruction::Code::Push},
+        {1, {Operand::Operator},                                 Instruction::Code::Add},
+        {1, {Operand::Function},                                 Instruction::Code::Call}
+    };
+
+    auto matches = [](const Lexem& lexem, Operand operand)
+    {
+        switch (operand)
+        {
+        case Operand::Value:
+            return lexem.type == Lexem::Type::Constant ||
+                   lexem.type == Lexem::Type::Variable ||
+                   lexem.type == Lexem::Type::Reduction;
+        case Operand::Operator:
+            return lexem.type == Lexem::Type::Function &&
+                   getOperation(std::get<const Function*>(lexem.value)) != Operation::None;
+        case Operand::Unary:
+            return lexem.type == Lexem::Type::Function &&
+                   std::get<const Function*>(lexem.value)->numberOfArguments == 1;
+        case Operand::Function:
+            return lexem.type == Lexem::Type::Function;
+        }
+
+        return false;
+    };
+
+    std::size_t position = 0;
+
+    while (position < m_expression.size())
+    {
+        const FusionRule* rule = nullptr;
+
+        for (auto&& candidate : rules)
+        {
+            if (position + candidate.length > m_expression.size())
+            {
+                continue;
+            }
+
+            auto matched = true;
+
+            for (std::size_t i = 0; i < candidate.length && matched; ++i)
+            {
+                matched = matches(m_expression[position + i], candidate.pattern[i]);
+            }
+
+            if (matched)
+            {
+                rule = &candidate;
+                break;
+            }
+        }
+
+        if (!rule)
+        {
+            throw StatementException("Unexpected lexem detected");
+        }
+
+        Instruction instruction = {};
+        instruction.code = rule->code;
+
+        std::size_t operands = 0;
+
+        for (std::size_t i = 0; i < rule->length; ++i)
+        {
+            auto& lexem = m_expression[position + i];
+
+            switch (rule->pattern[i])
+            {
+            case Operand::Value:
+                instruction.operands[operands++] = programValue(lexem);
+                break;
+
+            case Operand::Operator:
+                instruction.code = static_cast<Instruction::Code>(
+                    static_cast<int>(rule->code) +
+                    static_cast<int>(getOperation(std::get<const Function*>(lexem.value))) -
+                    static_cast<int>(Operation::Add)
+                );
+                break;
+
+            case Operand::Unary:
+            case Operand::Function:
+                instruction.function = std::get<const Function*>(lexem.value);
+                break;
+            }
+        }
+
+        m_program.push_back(instruction);
+
+        position += rule->length;
+    }
+
+    Instruction end = {};
+    end.code = Instruction::Code::Return;
+
+    m_program.push_back(end);
+}
+
+std::size_t Calculator::undefinedVariable() const
+{
+    for (auto slot : m_programVariables)
+    {
+        if (!m_variables[slot].defined && !m_variables[slot].provided)
+        {
+            return slot;
+        }
+    }
+
+    return m_variables.npos;
+}
+
+Calculator::ExecutionStatus Calculator::prepareExecution(std::size_t& undefinedSlot)
+{
+    provideVariables(m_referencedVariables, nullptr);
+
+    undefinedSlot = undefinedVariable();
+
+    if (undefinedSlot != m_variables.npos)
+    {
+        return ExecutionStatus::UndefinedVariable;
+    }
+
+    if (!computeReductions())
+    {
+        return ExecutionStatus::ArraySizeMismatch;
+    }
+
+    return ExecutionStatus::Success;
+}
+
+Calculator::NumberType Calculator::executeProgram()
+{
+    switch (m_backend)
+    {
+    case Backend::Register:
+        return executeRegisterProgram();
+    default:
+        return executeStackProgram();
+    }
+}
+
+#if defined(__GNUC__) && !defined(CALC_SWITCH_DISPATCH)
+#   define CALC_THREADED_DISPATCH
+#   define CALC_HANDLER(code) code:
+#   define CALC_NEXT() goto *(++instruction)->handler
+#else
+#   define CALC_HANDLER(code) case Instruction::Code::code:
+#   define CALC_NEXT() ++instruction; continue
+#endif
+
+#ifdef CALC_THREADED_DISPATCH
+// Labels as values
+#   pragma GCC diagnostic push
+#   pragma GCC diagnostic ignored "-Wpedantic"
+#endif
+
+Calculator::NumberType Calculator::executeStackProgram()
+{
+    auto& stack = m_executionStack;
+
+    NumberType rightValue;
+
+    if (m_program.empty())
+    {
+        throw StatementException("Unbalanced expression");
+    }
+
+    stack.clear();
+
+    auto instruction = m_program.data();
+
+#ifdef CALC_THREADED_DISPATCH
+    // Handlers in `Instruction::Code` order
+    static const void* const handlers[] = {
+        &&Push, &&Call, &&PushCall,
+        &&Add, &&Subtract, &&Multiply, &&Divide, &&Power,
+        &&PushAdd, &&PushSubtract, &&PushMultiply, &&PushDivide, &&PushPower,
+        &&PushPushAdd, &&PushPushSubtract, &&PushPushMultiply, &&PushPushDivide, &&PushPushPower,
+        &&Return
+    };
+
+    static_assert(
+        sizeof(handlers) / sizeof(handlers[0]) == static_cast<std::size_t>(Instruction::Code::Return) + 1,
+        "Every instruction code needs handler"
+    );
+
+    if (!m_programThreaded)
+    {
+        for (auto&& programInstruction : m_program)
+        {
+            programInstruction.handler = handlers[static_cast<std::size_t>(programInstruction.code)];
+        }
+
+        m_programThreaded = true;
+    }
+
+    goto *instruction->handler;
+#else
+    while (true)
+    {
+        switch (instruction->code)
+        {
+#endif
+
+    CALC_HANDLER(Push)
+        stack.push_back(*instruction->operands[0]);
+        CALC_NEXT();
+
+    CALC_HANDLER(Call)
+        stack.push_back(instruction->function->call(stack));
+        CALC_NEXT();
+
+    CALC_HANDLER(PushCall)
+        stack.push_back(*instruction->operands[0]);
+        stack.push_back(instruction->function->call(stack));
+        CALC_NEXT();
+
+    CALC_HANDLER(Add)
+        rightValue = stack.back();
+        stack.pop_back();
+        stack.back() += rightValue;
+        CALC_NEXT();
+
+    CALC_HANDLER(Subtract)
+        rightValue = stack.back();
+        stack.pop_back();
+        stack.back() -= rightValue;
+        CALC_NEXT();
+
+    CALC_HANDLER(Multiply)
+        rightValue = stack.back();
+        stack.pop_back();
+        stack.back() *= rightValue;
+        CALC_NEXT();
+
+    CALC_HANDLER(Divide)
+        rightValue = stack.back();
+        stack.pop_back();
+        stack.back() /= rightValue;
+        CALC_NEXT();
+
+    CALC_HANDLER(Power)
+        rightValue = stack.back();
+        stack.pop_back();
+        stack.back() = std::pow(stack.back(), rightValue);
+        CALC_NEXT();
+
+    CALC_HANDLER(PushAdd)
+        stack.back() += *instruction->operands[0];
+        CALC_NEXT();
+
+    CALC_HANDLER(PushSubtract)
+        stack.back() -= *instruction->operands[0];
+        CALC_NEXT();
+
+    CALC_HANDLER(PushMultiply)
+        stack.back() *= *instruction->operands[0];
+        CALC_NEXT();
+
+    CALC_HANDLER(PushDivide)
+        stack.back() /= *instruction->operands[0];
+        CALC_NEXT();
+
+    CALC_HANDLER(PushPower)
+        stack.back() = std::pow(stack.back(), *instruction->operands[0]);
+        CALC_NEXT();
+
+    CALC_HANDLER(PushPushAdd)
+        stack.push_back(*instruction->operands[0] + *instruction->operands[1]);
+        CALC_NEXT();
+
+    CALC_HANDLER(PushPushSubtract)
+        stack.push_back(*instruction->operands[0] - *instruction->operands[1]);
+        CALC_NEXT();
+
+    CALC_HANDLER(PushPushMultiply)
+        stack.push_back(*instruction->operands[0] * *instruction->operands[1]);
+        CALC_NEXT();
+
+    CALC_HANDLER(PushPushDivide)
+        stack.push_back(*instruction->operands[0] / *instruction->operands[1]);
+        CALC_NEXT();
+
+    CALC_HANDLER(PushPushPower)
+        stack.push_back(std::pow(*instruction->operands[0], *instruction->operands[1]));
+        CALC_NEXT();
+
+    CALC_HANDLER(Return)
+        goto finish;
+
+#ifndef CALC_THREADED_DISPATCH
+        }
+    }
+#endif
+
+finish:
+    if (stack.size() != 1) // Result
+    {
+        throw StatementException("Unbalanced expression");
+    }
+
+    return stack.front();
+}
+
+#ifdef CALC_THREADED_DISPATCH
+#   pragma GCC diagnostic pop
+#endif
+
+#undef CALC_HANDLER
+#undef CALC_NEXT
\ No newline at end of file
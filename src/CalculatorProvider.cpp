@@ -0,0 +1,77 @@
+#include <limits>
+#include "Calculator.hpp"
+
+std::vector<std::string_view> Calculator::referencedVariables() const
+{
+    std::vector<std::string_view> names;
+    names.reserve(m_referencedVariables.size());
+
+    for (auto slot : m_referencedVariables)
+    {
+        names.emplace_back(m_variables.name(slot));
+    }
+
+    return names;
+}
+
+void Calculator::setVariableProvider(VariableProvider provider, void* context)
+{
+    m_variableProvider = provider;
+    m_providerContext = context;
+
+    // Values of previous provider are not used
+    for (std::size_t slot = 0; slot < m_variables.size(); ++slot)
+    {
+        m_variables[slot].provided = false;
+    }
+}
+
+void Calculator::provideVariables(const std::vector<std::size_t>& slots, const NumberType* const* columns)
+{
+    if (m_variableProvider == nullptr)
+    {
+        return;
+    }
+
+    m_variableRequests.clear();
+    m_requestedSlots.clear();
+
+    for (auto slot : slots)
+    {
+        auto& variable = m_variables[slot];
+
+        variable.provided = false;
+
+        // Own values and columns are not requested
+        if (variable.defined || (columns && columns[slot]))
+        {
+            continue;
+        }
+
+        m_variableRequests.push_back({
+            m_variables.name(slot),
+            std::numeric_limits<NumberType>::quiet_NaN(),
+            false
+        });
+
+        m_requestedSlots.push_back(slot);
+    }
+
+    if (m_variableRequests.empty())
+    {
+        return;
+    }
+
+    m_variableProvider(m_variableRequests.data(), m_variableRequests.size(), m_providerContext);
+
+    for (std::size_t i = 0; i < m_variableRequests.size(); ++i)
+    {
+        if (m_variableRequests[i].found)
+        {
+            auto& variable = m_variables[m_requestedSlots[i]];
+
+            variable.value = m_variableRequests[i].value;
+            variable.provided = true;
+        }
+    }
+}
\ No newline at end of file
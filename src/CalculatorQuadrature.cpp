@@ -0,0 +1,374 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <StatementException.hpp>
+#include "Calculator.hpp"
+
+namespace
+{
+    // Number of points, that are computed at once.
+    const std::size_t BlockSize = 256;
+
+    // Number of points of Gauss-Kronrod rule.
+    const std::size_t KronrodPoints = 15;
+
+    // Nodes of Kronrod 15 point rule on [0, 1] without
+    // center. Odd nodes are nodes of Gauss 7 point rule.
+    const Calculator::NumberType KronrodNodes[] = {
+        0.991455371120812639206854697526329,
+        0.949107912342758524526189684047851,
+        0.864864423359769072789712788640926,
+        0.741531185599394439863864773280788,
+        0.586087235467691130294144845693013,
+        0.405845151377397166906606412076961,
+        0.207784955007898467600689403773245
+    };
+
+    // Weights of Kronrod rule. Last one is center weight.
+    const Calculator::NumberType KronrodWeights[] = {
+        0.022935322010529224963732008058970,
+        0.063092092629978553290700663189204,
+        0.104790010322250183839876322541518,
+        0.140653259715525918745189590510238,
+        0.169004726639267902826583426598550,
+        0.190350578064785409913256402421014,
+        0.204432940075298892414161999234649,
+        0.209482141084727828012999174891714
+    };
+
+    // Weights of Gauss rule. Last one is center weight.
+    const Calculator::NumberType GaussWeights[] = {
+        0.129484966168869693270611432679082,
+        0.279705391489276667901467771423780,
+        0.381830050505118944950369775488975,
+        0.417959183673469387755102040816327
+    };
+
+    // Nodes and weights of Gauss-Legendre rule on [-1, 1].
+    // Nodes are roots of Legendre polynomial, that are
+    // found by Newton's method.
+    void legendreRule(std::size_t points,
+                      std::vector<Calculator::NumberType>& nodes,
+                      std::vector<Calculator::NumberType>& weights)
+    {
+        nodes.resize(points);
+        weights.resize(points);
+
+        auto n = static_cast<Calculator::NumberType>(points);
+
+        for (std::size_t i = 0; i < (points + 1) / 2; ++i)
+        {
+            Calculator::NumberType z = std::cos(M_PI * (static_cast<Calculator::NumberType>(i) + 0.75) / (n + 0.5));
+            Calculator::NumberType derivative = 0;
+
+            for (int iteration = 0; iteration < 100; ++iteration)
+            {
+                Calculator::NumberType current = 1;
+                Calculator::NumberType previous = 0;
+
+                // Recurrence of Legendre polynomials
+                for (std::size_t j = 1; j <= points; ++j)
+                {
+                    auto k = static_cast<Calculator::NumberType>(j);
+                    auto next = ((2 * k - 1) * z * current - (k - 1) * previous) / k;
+
+                    previous = current;
+                    current = next;
+                }
+
+                derivative = n * (z * current - previous) / (z * z - 1);
+
+                auto step = current / derivative;
+
+                z -= step;
+
+                if (std::abs(step) <= 1e-15)
+                {
+                    break;
+                }
+            }
+
+            nodes[i] = -z;
+            nodes[points - 1 - i] = z;
+
+            weights[i] = weights[points - 1 - i] = 2 / ((1 - z * z) * derivative * derivative);
+        }
+    }
+}
+
+void Calculator::addIntegrationFunctions()
+{
+    addFunction(Calculator::Function("integrate", 4, 4, &Calculator::integrate));
+}
+
+void Calculator::setQuadrature(const QuadratureOptions& options)
+{
+    if (options.points == 0)
+    {
+        throw std::invalid_argument("Gauss-Legendre rule has no points");
+    }
+
+    if (!(options.absoluteTolerance >= 0) || !(options.relativeTolerance >= 0))
+    {
+        throw std::invalid_argument("Quadrature tolerance is negative");
+    }
+
+    m_quadrature = options;
+}
+
+Calculator::NumberType Calculator::integrate(ArgumentsStack& stack)
+{
+    stack.resize(stack.size() - 4);
+
+    return std::numeric_limits<NumberType>::quiet_NaN();
+}
+
+void Calculator::extractIntegral(Reduction& reduction) const
+{
+    auto& variable = reduction.arguments[1];
+
+    if (variable.size() != 1 || variable.front().type != Lexem::Type::Variable)
+    {
+        throw StatementException(
+            std::string("Second argument of \"")
+                .append(reduction.function->name)
+                .append("\" is not variable")
+        );
+    }
+
+    auto slot = std::get<std::size_t>(variable.front().value);
+
+    // Nested reductions are computed once before
+    // integral, so they can't depend on its variable.
+    auto dependsOn = [this, slot](const Lexem& lexem)
+    {
+        if (lexem.type == Lexem::Type::Variable)
+        {
+            return std::get<std::size_t>(lexem.value) == slot;
+        }
+
+        if (lexem.type != Lexem::Type::Reduction)
+        {
+            return false;
+        }
+
+        auto& nested = m_reductions[std::get<std::size_t>(lexem.value)];
+
+        return std::find(nested.variables.begin(), nested.variables.end(), slot) != nested.variables.end();
+    };
+
+    for (auto&& lexem : reduction.arguments[0])
+    {
+        if (lexem.type == Lexem::Type::Reduction && dependsOn(lexem))
+        {
+            throw StatementException("Nested reduction depends on integration variable");
+        }
+    }
+
+    for (std::size_t bound = 2; bound < 4; ++bound)
+    {
+        if (std::any_of(reduction.arguments[bound].begin(), reduction.arguments[bound].end(), dependsOn))
+        {
+            throw StatementException("Bounds of integral depend on integration variable");
+        }
+    }
+
+    reduction.variable = slot;
+
+    reduction.variables.erase(
+        std::remove(reduction.variables.begin(), reduction.variables.end(), slot),
+        reduction.variables.end()
+    );
+}
+
+void Calculator::computeIntegrand(const Reduction& reduction)
+{
+    auto count = m_quadraturePoints.size();
+
+    m_quadratureValues.resize(count);
+
+    m_reductionColumns[reduction.variable] = m_quadraturePoints.data();
+
+    for (std::size_t offset = 0; offset < count; offset += BlockSize)
+    {
+        auto blockCount = std::min(BlockSize, count - offset);
+
+        computeBlock(reduction.arguments[0], m_reductionColumns.data(), offset, blockCount, nullptr);
+
+        std::copy(
+            m_batchWorkspace.stack.begin(),
+            m_batchWorkspace.stack.begin() + blockCount,
+            m_quadratureValues.begin() + offset
+        );
+    }
+
+    m_reductionColumns[reduction.variable] = nullptr;
+}
+
+Calculator::NumberType Calculator::computeIntegral(Reduction& reduction)
+{
+    std::size_t depth = 0;
+
+    for (auto&& argument : reduction.arguments)
+    {
+        depth = std::max(depth, stackDepth(argument));
+    }
+
+    m_batchWorkspace.stack.resize(depth * BlockSize);
+
+    computeBlock(reduction.arguments[2], m_reductionColumns.data(), 0, 1, nullptr);
+    auto lower = m_batchWorkspace.stack[0];
+
+    computeBlock(reduction.arguments[3], m_reductionColumns.data(), 0, 1, nullptr);
+    auto upper = m_batchWorkspace.stack[0];
+
+    if (m_quadrature.method == QuadratureMethod::GaussLegendre)
+    {
+        if (m_legendreNodes.size() != m_quadrature.points)
+        {
+            legendreRule(m_quadrature.points, m_legendreNodes, m_legendreWeights);
+        }
+
+        auto center = (lower + upper) / 2;
+        auto halfLength = (upper - lower) / 2;
+
+        m_quadraturePoints.resize(m_legendreNodes.size());
+
+        for (std::size_t i = 0; i < m_legendreNodes.size(); ++i)
+        {
+            m_quadraturePoints[i] = center + halfLength * m_legendreNodes[i];
+        }
+
+        computeIntegrand(reduction);
+
+        NumberType result = 0;
+
+        for (std::size_t i = 0; i < m_legendreWeights.size(); ++i)
+        {
+            result += m_legendreWeights[i] * m_quadratureValues[i];
+        }
+
+        return result * halfLength;
+    }
+
+    // New intervals are at the end, so all of
+    // them are computed by one integrand call.
+    auto& intervals = m_quadratureIntervals;
+
+    intervals.assign(1, {lower, upper, 0, 0});
+
+    std::size_t first = 0;
+    std::size_t evaluations = 0;
+
+    for (;;)
+    {
+        m_quadraturePoints.resize((intervals.size() - first) * KronrodPoints);
+
+        auto point = m_quadraturePoints.data();
+
+        for (auto interval = intervals.begin() + first; interval != intervals.end(); ++interval)
+        {
+            auto center = (interval->lower + interval->upper) / 2;
+            auto halfLength = (interval->upper - interval->lower) / 2;
+
+            *point++ = center;
+
+            for (auto node : KronrodNodes)
+            {
+                *point++ = center - halfLength * node;
+                *point++ = center + halfLength * node;
+            }
+        }
+
+        computeIntegrand(reduction);
+
+        evaluations += m_quadraturePoints.size();
+
+        auto values = m_quadratureValues.data();
+
+        for (auto interval = intervals.begin() + first; interval != intervals.end(); ++interval)
+        {
+            auto kronrod = KronrodWeights[7] * values[0];
+            auto gauss = GaussWeights[3] * values[0];
+
+            for (std::size_t i = 0; i < 7; ++i)
+            {
+                auto sum = values[2 * i + 1] + values[2 * i + 2];
+
+                kronrod += KronrodWeights[i] * sum;
+
+                if (i % 2 == 1)
+                {
+                    gauss += GaussWeights[i / 2] * sum;
+                }
+            }
+
+            auto halfLength = (interval->upper - interval->lower) / 2;
+
+            interval->integral = kronrod * halfLength;
+            interval->error = std::abs((kronrod - gauss) * halfLength);
+
+            values += KronrodPoints;
+        }
+
+        NumberType integral = 0;
+        NumberType error = 0;
+
+        for (auto&& interval : intervals)
+        {
+            integral += interval.integral;
+            error += interval.error;
+        }
+
+        auto tolerance = std::max(
+            m_quadrature.absoluteTolerance,
+            m_quadrature.relativeTolerance * std::abs(integral)
+        );
+
+        // NaN integrand is not refined
+        if (!(error > tolerance))
+        {
+            return integral;
+        }
+
+        std::sort(
+            intervals.begin(),
+            intervals.end(),
+            [](const QuadratureInterval& lhs, const QuadratureInterval& rhs)
+            {
+                return lhs.error > rhs.error;
+            }
+        );
+
+        // Intervals with the largest errors are bisected,
+        // until error of the rest is small enough.
+        std::size_t bisected = 0;
+
+        while (bisected < intervals.size() &&
+               error > tolerance / 2 &&
+               evaluations + 2 * KronrodPoints * (bisected + 1) <= m_quadrature.maxEvaluations)
+        {
+            error -= intervals[bisected].error;
+            ++bisected;
+        }
+
+        if (bisected == 0)
+        {
+            return integral;
+        }
+
+        for (std::size_t i = 0; i < bisected; ++i)
+        {
+            auto interval = intervals[i];
+            auto middle = (interval.lower + interval.upper) / 2;
+
+            intervals.push_back({interval.lower, middle, 0, 0});
+            intervals.push_back({middle, interval.upper, 0, 0});
+        }
+
+        intervals.erase(intervals.begin(), intervals.begin() + static_cast<std::ptrdiff_t>(bisected));
+
+        first = intervals.size() - 2 * bisected;
+    }
+}
\ No newline at end of file
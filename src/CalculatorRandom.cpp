@@ -0,0 +1,318 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include "Calculator.hpp"
+
+namespace
+{
+    // Number of paths, that are computed at once.
+    const std::size_t BlockSize = 256;
+
+    // Number of paths in one task. Tasks don't depend
+    // on number of threads, so statistics are combined
+    // in the same order.
+    const std::size_t ChunkSize = 16 * BlockSize;
+
+    // Philox4x32-10 counter-based generator.
+    void philox(uint32_t (&counter)[4], uint64_t seed)
+    {
+        auto key0 = static_cast<uint32_t>(seed);
+        auto key1 = static_cast<uint32_t>(seed >> 32);
+
+        for (int round = 0; round < 10; ++round)
+        {
+            auto product0 = uint64_t(0xD2511F53) * counter[0];
+            auto product1 = uint64_t(0xCD9E8D57) * counter[2];
+
+            counter[0] = static_cast<uint32_t>(product1 >> 32) ^ counter[1] ^ key0;
+            counter[1] = static_cast<uint32_t>(product1);
+            counter[2] = static_cast<uint32_t>(product0 >> 32) ^ counter[3] ^ key1;
+            counter[3] = static_cast<uint32_t>(product0);
+
+            key0 += 0x9E3779B9;
+            key1 += 0xBB67AE85;
+        }
+    }
+
+    // Value in [0, 1) from 53 high bits
+    Calculator::NumberType toUniform(uint32_t high, uint32_t low)
+    {
+        return static_cast<Calculator::NumberType>(((uint64_t(high) << 32) | low) >> 11) * 0x1.0p-53;
+    }
+
+    Calculator::NumberType uniformValue(uint64_t seed, uint32_t site, uint64_t draw)
+    {
+        uint32_t counter[4] = {
+            static_cast<uint32_t>(draw),
+            static_cast<uint32_t>(draw >> 32),
+            site,
+            0
+        };
+
+        philox(counter, seed);
+
+        return toUniform(counter[0], counter[1]);
+    }
+
+    // Box-Muller transform of one generator output
+    Calculator::NumberType normalValue(uint64_t seed, uint32_t site, uint64_t draw)
+    {
+        uint32_t counter[4] = {
+            static_cast<uint32_t>(draw),
+            static_cast<uint32_t>(draw >> 32),
+            site,
+            1
+        };
+
+        philox(counter, seed);
+
+        auto radius = std::sqrt(-2 * std::log(1 - toUniform(counter[0], counter[1])));
+
+        return radius * std::cos(2 * M_PI * toUniform(counter[2], counter[3]));
+    }
+
+    // Running statistics of paths.
+    struct Statistics
+    {
+        std::size_t count;
+        Calculator::NumberType mean;
+
+        // Sum of squared deviations from mean.
+        Calculator::NumberType deviations;
+
+        Calculator::NumberType min;
+        Calculator::NumberType max;
+    };
+
+    void merge(Statistics& lhs, const Statistics& rhs)
+    {
+        if (rhs.count == 0)
+        {
+            return;
+        }
+
+        if (lhs.count == 0)
+        {
+            lhs = rhs;
+            return;
+        }
+
+        auto count = lhs.count + rhs.count;
+        auto delta = rhs.mean - lhs.mean;
+
+        lhs.mean += delta * static_cast<Calculator::NumberType>(rhs.count) / static_cast<Calculator::NumberType>(count);
+        lhs.deviations += rhs.deviations +
+            delta * delta * static_cast<Calculator::NumberType>(lhs.count) *
+            static_cast<Calculator::NumberType>(rhs.count) / static_cast<Calculator::NumberType>(count);
+        lhs.count = count;
+        lhs.min = std::min(lhs.min, rhs.min);
+        lhs.max = std::max(lhs.max, rhs.max);
+    }
+}
+
+void Calculator::addRandomFunctions()
+{
+    addFunction(Calculator::Function("uniform", 0, 4, &Calculator::randomUniform, nullptr));
+    addFunction(Calculator::Function("normal",  0, 4, &Calculator::randomNormal,  nullptr));
+}
+
+void Calculator::setRandomSeed(uint64_t seed)
+{
+    m_randomSeed = seed;
+
+    for (auto&& stream : m_streams)
+    {
+        stream.seed = seed;
+    }
+
+    resetStreams();
+}
+
+bool Calculator::isRandom(const Function* function)
+{
+    return function->contextFunction == &Calculator::randomUniform ||
+           function->contextFunction == &Calculator::randomNormal;
+}
+
+Calculator::NumberType Calculator::randomUniform(ArgumentsStack& /* stack */, void* context)
+{
+    auto& stream = *static_cast<Stream*>(context);
+
+    return uniformValue(stream.seed, stream.site, stream.count++);
+}
+
+Calculator::NumberType Calculator::randomNormal(ArgumentsStack& /* stack */, void* context)
+{
+    auto& stream = *static_cast<Stream*>(context);
+
+    return normalValue(stream.seed, stream.site, stream.count++);
+}
+
+Calculator::SimulationResult Calculator::simulate(std::size_t paths, std::size_t threads)
+{
+    std::size_t undefinedSlot = m_variables.npos;
+
+    if (m_expression.empty())
+    {
+        throw StatementException("Unbalanced expression");
+    }
+
+    switch (prepareExecution(undefinedSlot))
+    {
+    case ExecutionStatus::UndefinedVariable:
+        throw CalculationException(
+            std::string("No variable \"")
+                .append(m_variables.name(undefinedSlot))
+                .append("\" defined")
+        );
+
+    case ExecutionStatus::ArraySizeMismatch:
+        throw CalculationException("Arrays in reduction have different sizes");
+
+    default:
+        break;
+    }
+
+    // Random call sites are replaced with columns,
+    // that follow variable slots.
+    LexemStack expression = m_expression;
+
+    std::vector<const Stream*> sites;
+
+    for (auto&& lexem : expression)
+    {
+        if (lexem.type != Lexem::Type::Function ||
+            !isStream(std::get<const Function*>(lexem.value)))
+        {
+            continue;
+        }
+
+        auto function = std::get<const Function*>(lexem.value);
+
+        if (!isRandom(function))
+        {
+            throw std::invalid_argument(
+                std::string("Stateful function \"")
+                    .append(function->name)
+                    .append("\" can't be simulated")
+            );
+        }
+
+        sites.push_back(static_cast<const Stream*>(function->context));
+
+        lexem = Lexem(Lexem::Type::Variable, m_variables.size() + sites.size() - 1);
+    }
+
+    auto depth = stackDepth(expression);
+    auto chunks = (paths + ChunkSize - 1) / ChunkSize;
+
+    std::vector<Statistics> results(chunks);
+
+    std::atomic<std::size_t> nextChunk(0);
+
+    auto worker = [&]()
+    {
+        BatchWorkspace workspace;
+        workspace.stack.resize(depth * BlockSize);
+
+        std::vector<NumberType> random(sites.size() * BlockSize);
+
+        // Variables are broadcast
+        std::vector<const NumberType*> columns(m_variables.size() + sites.size(), nullptr);
+
+        for (std::size_t i = 0; i < sites.size(); ++i)
+        {
+            columns[m_variables.size() + i] = random.data() + i * BlockSize;
+        }
+
+        for (auto chunk = nextChunk++; chunk < chunks; chunk = nextChunk++)
+        {
+            Statistics statistics = {
+                0,
+                0,
+                0,
+                std::numeric_limits<NumberType>::infinity(),
+                -std::numeric_limits<NumberType>::infinity()
+            };
+
+            auto end = std::min(paths, (chunk + 1) * ChunkSize);
+
+            for (auto path = chunk * ChunkSize; path < end; path += BlockSize)
+            {
+                auto count = std::min(BlockSize, end - path);
+
+                for (std::size_t i = 0; i < sites.size(); ++i)
+                {
+                    auto values = random.data() + i * BlockSize;
+                    auto normal = sites[i]->function.contextFunction == &Calculator::randomNormal;
+
+                    for (std::size_t row = 0; row < count; ++row)
+                    {
+                        values[row] = normal ?
+                            normalValue(sites[i]->seed, sites[i]->site, path + row) :
+                            uniformValue(sites[i]->seed, sites[i]->site, path + row);
+                    }
+                }
+
+                computeBlock(expression, columns.data(), 0, count, nullptr, workspace);
+
+                // Welford's update
+                for (std::size_t row = 0; row < count; ++row)
+                {
+                    auto value = workspace.stack[row];
+                    auto delta = value - statistics.mean;
+
+                    ++statistics.count;
+
+                    statistics.mean += delta / static_cast<NumberType>(statistics.count);
+                    statistics.deviations += delta * (value - statistics.mean);
+                    statistics.min = std::min(statistics.min, value);
+                    statistics.max = std::max(statistics.max, value);
+                }
+            }
+
+            results[chunk] = statistics;
+        }
+    };
+
+    runParallel(threads, chunks, worker);
+
+    Statistics total = {
+        0,
+        0,
+        0,
+        std::numeric_limits<NumberType>::infinity(),
+        -std::numeric_limits<NumberType>::infinity()
+    };
+
+    for (auto&& statistics : results)
+    {
+        merge(total, statistics);
+    }
+
+    SimulationResult result = {
+        total.count,
+        std::numeric_limits<NumberType>::quiet_NaN(),
+        std::numeric_limits<NumberType>::quiet_NaN(),
+        std::numeric_limits<NumberType>::quiet_NaN(),
+        std::numeric_limits<NumberType>::quiet_NaN(),
+        std::numeric_limits<NumberType>::quiet_NaN()
+    };
+
+    if (total.count > 0)
+    {
+        result.mean = total.mean;
+        result.min = total.min;
+        result.max = total.max;
+    }
+
+    if (total.count > 1)
+    {
+        result.variance = total.deviations / static_cast<NumberType>(total.count - 1);
+        result.standardError = std::sqrt(result.variance / static_cast<NumberType>(total.count));
+    }
+
+    return result;
+}
\ No newline at end of file
@@ -0,0 +1,138 @@
+#include <algorithm>
+#include "Calculator.hpp"
+
+namespace
+{
+    // Register index of values, that are read in place.
+    const std::size_t NoRegister = static_cast<std::size_t>(-1);
+}
+
+void Calculator::buildRegisterProgram()
+{
+    auto functions = std::count_if(
+        m_expression.begin(),
+        m_expression.end(),
+        [](const Lexem& lexem)
+        {
+            return lexem.type == Lexem::Type::Function;
+        }
+    );
+
+    // Registers are referenced by pointers. Every
+    // function needs one register at most.
+    m_registers.assign(static_cast<std::size_t>(functions), 0);
+
+    // Computed values with their registers
+    std::vector<std::pair<const NumberType*, std::size_t>> values;
+
+    // Registers, that are not used by computed values
+    std::vector<std::size_t> freeRegisters;
+    std::size_t usedRegisters = 0;
+
+    std::vector<std::size_t> sourceOffsets;
+
+    for (auto&& lexem : m_expression)
+    {
+        switch (lexem.type)
+        {
+        case Lexem::Type::Constant:
+        case Lexem::Type::Variable:
+        case Lexem::Type::Reduction:
+            values.emplace_back(programValue(lexem), NoRegister);
+            break;
+
+        case Lexem::Type::Function:
+        {
+            auto function = std::get<const Function*>(lexem.value);
+            auto first = values.size() - function->numberOfArguments;
+
+            RegisterInstruction instruction = {};
+            instruction.operation = getOperation(function);
+            instruction.function = function;
+
+            sourceOffsets.push_back(m_registerSources.size());
+
+            // Every value is used once, so registers
+            // of arguments are free after instruction.
+            for (auto value = values.begin() + first; value != values.end(); ++value)
+            {
+                m_registerSources.push_back(value->first);
+
+                if (value->second != NoRegister)
+                {
+                    freeRegisters.push_back(value->second);
+                }
+            }
+
+            values.resize(first);
+
+            std::size_t destination;
+
+            if (freeRegisters.empty())
+            {
+                destination = usedRegisters++;
+            }
+            else
+            {
+                destination = freeRegisters.back();
+                freeRegisters.pop_back();
+            }
+
+            instruction.destination = &m_registers[destination];
+
+            m_registerProgram.push_back(instruction);
+
+            values.emplace_back(&m_registers[destination], destination);
+
+            break;
+        }
+
+        default:
+            throw StatementException("Unexpected lexem detected");
+        }
+    }
+
+    // Sources are placed, so pointers are stable now
+    for (std::size_t i = 0; i < m_registerProgram.size(); ++i)
+    {
+        m_registerProgram[i].sources = m_registerSources.data() + sourceOffsets[i];
+    }
+
+    // Shrinking does not reallocate registers
+    m_registers.resize(usedRegisters);
+
+    m_registerResult = (values.size() == 1) ? values.back().first : nullptr;
+}
+
+Calculator::NumberType Calculator::executeRegisterProgram()
+{
+    for (auto&& instruction : m_registerProgram)
+    {
+        if (instruction.operation != Operation::None)
+        {
+            *instruction.destination = operate(
+                instruction.operation,
+                *instruction.sources[0],
+                *instruction.sources[1]
+            );
+
+            continue;
+        }
+
+        m_executionStack.clear();
+
+        for (uint32_t i = 0; i < instruction.function->numberOfArguments; ++i)
+        {
+            m_executionStack.push_back(*instruction.sources[i]);
+        }
+
+        *instruction.destination = instruction.function->call(m_executionStack);
+    }
+
+    if (!m_registerResult)
+    {
+        throw StatementException("Unbalanced expression");
+    }
+
+    return *m_registerResult;
+}
\ No newline at end of file
@@ -0,0 +1,148 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include "Calculator.hpp"
+
+std::shared_ptr<const Calculator::FunctionTable> Calculator::sharedFunctions(unsigned sets)
+{
+    // Registries of all set combinations are built
+    // once. Initialization of static is thread-safe,
+    // so lookup does not need locking.
+    static const auto registries = []()
+    {
+        std::array<std::shared_ptr<const FunctionTable>, FunctionSetsCount> result;
+
+        for (unsigned combination = 0; combination < FunctionSetsCount; ++combination)
+        {
+            auto registry = std::make_shared<FunctionTable>();
+
+            fillOperators(*registry);
+            fillFunctionSets(*registry, combination);
+
+            registry->freeze();
+
+            result[combination] = std::move(registry);
+        }
+
+        return result;
+    }();
+
+    return registries[sets];
+}
+
+std::shared_ptr<const SymbolTable<Calculator::NumberType>> Calculator::sharedConstants()
+{
+    static auto constants = []()
+    {
+        auto table = std::make_shared<SymbolTable<NumberType>>();
+
+        table->insert("Pi", M_PI);
+        table->insert("e",  M_E);
+
+        table->freeze();
+
+        return table;
+    }();
+
+    return constants;
+}
+
+void Calculator::insertFunction(FunctionTable& functions, Function function)
+{
+    auto name = function.name;
+
+    functions.insert(name, std::move(function));
+}
+
+void Calculator::fillFunctionSets(FunctionTable& functions, unsigned sets)
+{
+    if (sets & BasicFunctionSet)
+    {
+        fillBasicFunctions(functions);
+    }
+
+    if (sets & LogicFunctionSet)
+    {
+        fillLogicFunctions(functions);
+    }
+
+    if (sets & ArrayFunctionSet)
+    {
+        fillArrayFunctions(functions);
+    }
+}
+
+void Calculator::addFunctionSets(unsigned sets)
+{
+    if (m_functions.size() == m_functions.sharedSize())
+    {
+        // There are no own functions, so
+        // registry is replaced with shared one.
+        m_functionSets |= sets;
+        m_functions = FunctionTable(sharedFunctions(m_functionSets));
+    }
+    else
+    {
+        fillFunctionSets(m_functions, sets);
+    }
+
+    // Program can contain replaced operator
+    if (!m_expression.empty())
+    {
+        buildProgram();
+    }
+}
+
+void Calculator::addBasicFunctions()
+{
+    addFunctionSets(BasicFunctionSet);
+}
+
+void Calculator::addLogicFunctions()
+{
+    addFunctionSets(LogicFunctionSet);
+}
+
+void Calculator::addArrayFunctions()
+{
+    addFunctionSets(ArrayFunctionSet);
+}
+
+void Calculator::rebindFunction(const Function* from, const Function* to)
+{
+    auto rebind = [from, to](LexemStack& expression)
+    {
+        for (auto&& lexem : expression)
+        {
+            if (lexem.type == Lexem::Type::Function &&
+                std::get<const Function*>(lexem.value) == from)
+            {
+                lexem.value = to;
+            }
+        }
+    };
+
+    rebind(m_expression);
+    rebind(m_generalExpression);
+
+    for (auto&& reduction : m_reductions)
+    {
+        if (reduction.function == from)
+        {
+            reduction.function = to;
+        }
+
+        for (auto&& argument : reduction.arguments)
+        {
+            rebind(argument);
+        }
+    }
+
+    // Bodies of user-defined functions
+    for (auto index = m_functions.sharedSize(); index < m_functions.size(); ++index)
+    {
+        rebind(m_functions[index].body);
+    }
+
+    std::replace(m_storeFunctions.begin(), m_storeFunctions.end(), from, to);
+}
\ No newline at end of file
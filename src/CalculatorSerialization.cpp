@@ -0,0 +1,577 @@
+#include <istream>
+#include <ostream>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <unordered_map>
+#include <SerializationException.hpp>
+#include "Calculator.hpp"
+
+namespace
+{
+    // "ECLC" signature.
+    const uint32_t FileSignature = 0x434C4345;
+
+    // Has to be increased on any format change.
+    const uint32_t FormatVersion = 1;
+
+    // Written in native byte order. Reading it back in
+    // other order means that file was written on machine
+    // with other endianness.
+    const uint32_t ByteOrderMark = 0x01020304;
+
+    template<typename T>
+    void writeValue(std::ostream& stream, const T& value)
+    {
+        stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    void writeString(std::ostream& stream, const std::string& string)
+    {
+        writeValue(stream, static_cast<uint32_t>(string.size()));
+        stream.write(string.data(), static_cast<std::streamsize>(string.size()));
+    }
+
+    template<typename T>
+    T readValue(std::istream& stream)
+    {
+        T value;
+
+        if (!stream.read(reinterpret_cast<char*>(&value), sizeof(T)))
+        {
+            throw SerializationException("Unexpected end of expression data");
+        }
+
+        return value;
+    }
+
+    std::string readString(std::istream& stream)
+    {
+        // Size is read from data, so damaged size
+        // does not allocate more than data has.
+        const std::size_t ChunkSize = 4096;
+
+        auto size = readValue<uint32_t>(stream);
+
+        std::string result;
+
+        while (result.size() < size)
+        {
+            auto offset = result.size();
+            auto chunk = std::min<std::size_t>(ChunkSize, size - offset);
+
+            result.resize(offset + chunk);
+
+            if (!stream.read(&result[offset], static_cast<std::streamsize>(chunk)))
+            {
+                throw SerializationException("Unexpected end of expression data");
+            }
+        }
+
+        return result;
+    }
+
+    // Constants are pooled by bit patterns,
+    // so -0.0 and 0.0 are different.
+    uint64_t bitPattern(Calculator::NumberType value)
+    {
+        static_assert(sizeof(Calculator::NumberType) == sizeof(uint64_t), "Number type has unexpected size");
+
+        uint64_t pattern;
+        std::memcpy(&pattern, &value, sizeof(pattern));
+
+        return pattern;
+    }
+
+    template<typename Key, typename Value>
+    uint32_t poolIndex(std::vector<Value>& pool,
+                       std::unordered_map<Key, uint32_t>& indices,
+                       const Key& key,
+                       const Value& value)
+    {
+        auto index = indices.emplace(key, static_cast<uint32_t>(pool.size())).first->second;
+
+        if (index == pool.size())
+        {
+            pool.push_back(value);
+        }
+
+        return index;
+    }
+}
+
+void Calculator::encodeExpression(std::vector<NumberType>& constants,
+                                  std::vector<std::size_t>& variables,
+                                  std::vector<const Function*>& functions,
+                                  SavedProgram& program) const
+{
+    program.reserve(m_expression.size());
+
+    std::unordered_map<uint64_t, uint32_t> constantIndices;
+    std::unordered_map<std::size_t, uint32_t> variableIndices;
+    std::unordered_map<const Function*, uint32_t> functionIndices;
+
+    auto constantIndex = [&](NumberType value)
+    {
+        return poolIndex(constants, constantIndices, bitPattern(value), value);
+    };
+
+    auto functionIndex = [&](const Function* function)
+    {
+        return poolIndex(functions, functionIndices, function, function);
+    };
+
+    for (auto&& lexem : m_expression)
+    {
+        switch (lexem.type)
+        {
+        case Lexem::Type::Constant:
+            program.emplace_back(
+                static_cast<uint8_t>(lexem.type),
+                constantIndex(std::get<NumberType>(lexem.value))
+            );
+            break;
+
+        case Lexem::Type::Variable:
+        {
+            auto slot = std::get<std::size_t>(lexem.value);
+
+            program.emplace_back(
+                static_cast<uint8_t>(lexem.type),
+                poolIndex(variables, variableIndices, slot, slot)
+            );
+            break;
+        }
+
+        case Lexem::Type::Function:
+        {
+            auto function = std::get<const Function*>(lexem.value);
+
+            // Table references are indices of tables of
+            // this calculator, they are not part of format.
+            if (function->context == &m_tables)
+            {
+                throw SerializationException(
+                    std::string("Expression with \"")
+                        .append(function->name)
+                        .append("\" can't be saved")
+                );
+            }
+
+            if (function->contextFunction == &Calculator::evaluatePolynomial)
+            {
+                // Polynomial is written in Horner's form with
+                // built-in operators. Variable is argument.
+                auto polynomial = static_cast<const Polynomial*>(function->context);
+                auto& coefficients = polynomial->coefficients;
+
+                auto variable = program.back();
+                program.pop_back();
+
+                auto add = &m_functions[m_functions.find("+")];
+                auto multiply = &m_functions[m_functions.find("*")];
+
+                program.emplace_back(
+                    static_cast<uint8_t>(Lexem::Type::Constant),
+                    constantIndex(coefficients[polynomial->count - 1])
+                );
+
+                for (auto i = polynomial->count - 1; i-- > 0;)
+                {
+                    program.push_back(variable);
+                    program.emplace_back(static_cast<uint8_t>(lexem.type), functionIndex(multiply));
+                    program.emplace_back(
+                        static_cast<uint8_t>(Lexem::Type::Constant),
+                        constantIndex(coefficients[i])
+                    );
+                    program.emplace_back(static_cast<uint8_t>(lexem.type), functionIndex(add));
+                }
+
+                break;
+            }
+
+            program.emplace_back(
+                static_cast<uint8_t>(lexem.type),
+                functionIndex(function)
+            );
+            break;
+        }
+
+        case Lexem::Type::Reduction:
+            // Array arguments of reductions and integrals
+            // are not part of format.
+            throw SerializationException(
+                std::string("Expression with \"")
+                    .append(m_reductions[std::get<std::size_t>(lexem.value)].function->name)
+                    .append("\" can't be saved")
+            );
+
+        default:
+            throw SerializationException("Unexpected lexem in expression");
+        }
+    }
+}
+
+void Calculator::saveExpression(std::ostream& stream) const
+{
+    std::vector<NumberType> constants;
+    std::vector<std::size_t> variables;
+    std::vector<const Function*> functions;
+
+    SavedProgram program;
+
+    encodeExpression(constants, variables, functions, program);
+
+    // Header
+    writeValue(stream, FileSignature);
+    writeValue(stream, FormatVersion);
+    writeValue(stream, ByteOrderMark);
+    writeValue(stream, static_cast<uint8_t>(sizeof(NumberType)));
+
+    // Constant pool
+    writeValue(stream, static_cast<uint32_t>(constants.size()));
+
+    for (auto&& constant : constants)
+    {
+        writeValue(stream, constant);
+    }
+
+    // Variable names
+    writeValue(stream, static_cast<uint32_t>(variables.size()));
+
+    for (auto&& variable : variables)
+    {
+        writeString(stream, m_variables.name(variable));
+    }
+
+    // Function references
+    writeValue(stream, static_cast<uint32_t>(functions.size()));
+
+    for (auto&& function : functions)
+    {
+        writeString(stream, function->name);
+        writeValue(stream, function->numberOfArguments);
+    }
+
+    // Program
+    writeValue(stream, static_cast<uint32_t>(program.size()));
+
+    for (auto&& instruction : program)
+    {
+        writeValue(stream, instruction.first);
+        writeValue(stream, instruction.second);
+    }
+
+    if (!stream)
+    {
+        throw SerializationException("Can't write expression data");
+    }
+}
+
+void Calculator::loadExpression(std::istream& stream)
+{
+    if (readValue<uint32_t>(stream) != FileSignature)
+    {
+        throw SerializationException("Data is not a saved expression");
+    }
+
+    if (readValue<uint32_t>(stream) != FormatVersion)
+    {
+        throw SerializationException("Unsupported expression format version");
+    }
+
+    if (readValue<uint32_t>(stream) != ByteOrderMark)
+    {
+        throw SerializationException("Expression was saved with different byte order");
+    }
+
+    if (readValue<uint8_t>(stream) != sizeof(NumberType))
+    {
+        throw SerializationException("Expression was saved with different number type");
+    }
+
+    // Counts are read from data, so pools grow with
+    // read elements instead of being allocated at once.
+
+    // Constant pool
+    std::vector<NumberType> constants;
+
+    for (auto count = readValue<uint32_t>(stream); count > 0; --count)
+    {
+        constants.push_back(readValue<NumberType>(stream));
+    }
+
+    // Variable names. Slots are created only
+    // for valid expression.
+    std::vector<std::string> variables;
+
+    for (auto count = readValue<uint32_t>(stream); count > 0; --count)
+    {
+        variables.push_back(readString(stream));
+    }
+
+    // Function references
+    std::vector<const Function*> functions;
+
+    for (auto count = readValue<uint32_t>(stream); count > 0; --count)
+    {
+        auto name = readString(stream);
+        auto numberOfArguments = readValue<uint32_t>(stream);
+
+        auto searchResult = m_functions.find(name);
+
+        if (searchResult == m_functions.npos)
+        {
+            throw SerializationException(
+                std::string("Expression references unknown function \"")
+                    .append(name)
+                    .append("\"")
+            );
+        }
+
+        if (std::as_const(m_functions)[searchResult].numberOfArguments != numberOfArguments)
+        {
+            throw SerializationException(
+                std::string("Function \"")
+                    .append(name)
+                    .append("\" has different number of arguments")
+            );
+        }
+
+        functions.push_back(&std::as_const(m_functions)[searchResult]);
+    }
+
+    // Program
+    LexemStack expression;
+
+    auto size = readValue<uint32_t>(stream);
+
+    for (uint32_t i = 0; i < size; ++i)
+    {
+        auto type = static_cast<Lexem::Type>(readValue<uint8_t>(stream));
+        auto index = readValue<uint32_t>(stream);
+
+        switch (type)
+        {
+        case Lexem::Type::Constant:
+            if (index >= constants.size())
+            {
+                throw SerializationException("Constant index is out of range");
+            }
+
+            expression.emplace_back(Lexem(type, constants[index]));
+            break;
+
+        case Lexem::Type::Variable:
+            if (index >= variables.size())
+            {
+                throw SerializationException("Variable index is out of range");
+            }
+
+            // Pool index is replaced with slot
+            // after validation.
+            expression.emplace_back(Lexem(type, static_cast<std::size_t>(index)));
+            break;
+
+        case Lexem::Type::Function:
+            if (index >= functions.size())
+            {
+                throw SerializationException("Function index is out of range");
+            }
+
+            expression.emplace_back(Lexem(type, functions[index]));
+            break;
+
+        default:
+            throw SerializationException("Unexpected lexem in expression data");
+        }
+    }
+
+    m_expression = std::move(expression);
+    m_reductions.clear();
+    m_polynomials.clear();
+    m_streams.clear();
+    m_generalExpression.clear();
+
+    resetProfile();
+
+    try
+    {
+        performValidation();
+        instantiateStreams();
+    }
+    catch (StatementException& e)
+    {
+        clearExpression();
+
+        throw SerializationException(
+            std::string("Loaded expression is invalid: ").append(e.what())
+        );
+    }
+
+    std::vector<std::size_t> slots;
+    slots.reserve(variables.size());
+
+    for (auto&& name : variables)
+    {
+        slots.push_back(m_variables.intern(name));
+    }
+
+    for (auto&& lexem : m_expression)
+    {
+        if (lexem.type == Lexem::Type::Variable)
+        {
+            lexem.value = slots[std::get<std::size_t>(lexem.value)];
+        }
+    }
+
+    buildProgram();
+}
+
+void Calculator::saveStore(std::ostream& stream, const std::vector<std::string_view>& expressions)
+{
+    // Constant pools and programs of expressions
+    std::vector<std::vector<NumberType>> constants(expressions.size());
+    std::vector<std::vector<ExpressionStore::Instruction>> programs(expressions.size());
+
+    // Store-wide variables and functions, so
+    // calculators resolve every name once.
+    std::vector<std::size_t> variables;
+    std::vector<const Function*> functions;
+
+    std::unordered_map<std::size_t, uint32_t> variableIndices;
+    std::unordered_map<const Function*, uint32_t> functionIndices;
+
+    for (std::size_t i = 0; i < expressions.size(); ++i)
+    {
+        setExpression(expressions[i]);
+
+        std::vector<std::size_t> expressionVariables;
+        std::vector<const Function*> expressionFunctions;
+
+        SavedProgram program;
+
+        encodeExpression(constants[i], expressionVariables, expressionFunctions, program);
+
+        for (auto&& instruction : program)
+        {
+            auto type = static_cast<Lexem::Type>(instruction.first);
+            auto index = instruction.second;
+
+            if (type == Lexem::Type::Variable)
+            {
+                auto slot = expressionVariables[index];
+
+                index = variableIndices.emplace(slot, static_cast<uint32_t>(variables.size())).first->second;
+
+                if (index == variables.size())
+                {
+                    variables.push_back(slot);
+                }
+            }
+            else if (type == Lexem::Type::Function)
+            {
+                auto function = expressionFunctions[index];
+
+                index = functionIndices.emplace(function, static_cast<uint32_t>(functions.size())).first->second;
+
+                if (index == functions.size())
+                {
+                    functions.push_back(function);
+                }
+            }
+
+            programs[i].push_back({instruction.first, index});
+        }
+    }
+
+    // Layout. Arrays of numbers go first,
+    // so they are aligned.
+    ExpressionStore::Header header = {};
+    header.signature = ExpressionStore::Signature;
+    header.version = ExpressionStore::Version;
+    header.byteOrder = ExpressionStore::ByteOrderMark;
+    header.numberSize = sizeof(NumberType);
+    header.expressionsCount = static_cast<uint32_t>(expressions.size());
+    header.variablesCount = static_cast<uint32_t>(variables.size());
+    header.functionsCount = static_cast<uint32_t>(functions.size());
+
+    uint64_t offset = sizeof(header);
+
+    header.expressionsOffset = offset;
+    offset += expressions.size() * sizeof(ExpressionStore::Expression);
+
+    header.variablesOffset = offset;
+    offset += variables.size() * sizeof(ExpressionStore::Name);
+
+    header.functionsOffset = offset;
+    offset += functions.size() * sizeof(ExpressionStore::Name);
+
+    writeValue(stream, header);
+
+    for (std::size_t i = 0; i < expressions.size(); ++i)
+    {
+        ExpressionStore::Expression entry = {};
+        entry.constantsOffset = offset;
+        entry.constantsCount = static_cast<uint32_t>(constants[i].size());
+        offset += constants[i].size() * sizeof(NumberType);
+
+        entry.programOffset = offset;
+        entry.programSize = static_cast<uint32_t>(programs[i].size());
+        offset += programs[i].size() * sizeof(ExpressionStore::Instruction);
+
+        writeValue(stream, entry);
+    }
+
+    // Names are placed after programs
+    for (auto&& variable : variables)
+    {
+        ExpressionStore::Name name = {};
+        name.offset = offset;
+        name.size = static_cast<uint32_t>(m_variables.name(variable).size());
+        offset += name.size;
+
+        writeValue(stream, name);
+    }
+
+    for (auto&& function : functions)
+    {
+        ExpressionStore::Name name = {};
+        name.offset = offset;
+        name.size = static_cast<uint32_t>(function->name.size());
+        name.numberOfArguments = function->numberOfArguments;
+        offset += name.size;
+
+        writeValue(stream, name);
+    }
+
+    for (std::size_t i = 0; i < expressions.size(); ++i)
+    {
+        stream.write(
+            reinterpret_cast<const char*>(constants[i].data()),
+            static_cast<std::streamsize>(constants[i].size() * sizeof(NumberType))
+        );
+
+        stream.write(
+            reinterpret_cast<const char*>(programs[i].data()),
+            static_cast<std::streamsize>(programs[i].size() * sizeof(ExpressionStore::Instruction))
+        );
+    }
+
+    for (auto&& variable : variables)
+    {
+        auto& name = m_variables.name(variable);
+
+        stream.write(name.data(), static_cast<std::streamsize>(name.size()));
+    }
+
+    for (auto&& function : functions)
+    {
+        stream.write(function->name.data(), static_cast<std::streamsize>(function->name.size()));
+    }
+
+    if (!stream)
+    {
+        throw SerializationException("Can't write expression store");
+    }
+}
\ No newline at end of file
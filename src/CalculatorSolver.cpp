@@ -0,0 +1,832 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include "Calculator.hpp"
+
+namespace
+{
+    // Number of rows, that are solved at once.
+    const std::size_t BlockSize = 256;
+
+    // Number of rows in one task.
+    const std::size_t ChunkSize = 16 * BlockSize;
+
+    // State of Brent's method: bracket ends `a` and `c`,
+    // best point `b`, their values, last steps `d` and `e`.
+    enum BrentState
+    {
+        BrentA,
+        BrentB,
+        BrentC,
+        BrentFa,
+        BrentFb,
+        BrentFc,
+        BrentD,
+        BrentE,
+        BrentStateSize
+    };
+
+    // State of Newton's method: point and previous
+    // point with its value for secant steps.
+    enum NewtonState
+    {
+        NewtonX,
+        NewtonPreviousX,
+        NewtonPreviousValue,
+        NewtonStateSize
+    };
+
+    // Step of Brent's method after evaluation in `b`.
+    // Returns true, if `b` is root.
+    bool brentStep(Calculator::NumberType* state, Calculator::NumberType tolerance)
+    {
+        auto& a = state[BrentA];
+        auto& b = state[BrentB];
+        auto& c = state[BrentC];
+        auto& fa = state[BrentFa];
+        auto& fb = state[BrentFb];
+        auto& fc = state[BrentFc];
+        auto& d = state[BrentD];
+        auto& e = state[BrentE];
+
+        if ((fb > 0 && fc > 0) || (fb < 0 && fc < 0))
+        {
+            c = a;
+            fc = fa;
+            e = d = b - a;
+        }
+
+        if (std::abs(fc) < std::abs(fb))
+        {
+            a = b;
+            b = c;
+            c = a;
+            fa = fb;
+            fb = fc;
+            fc = fa;
+        }
+
+        auto accuracy = 2 * std::numeric_limits<Calculator::NumberType>::epsilon() * std::abs(b) + tolerance / 2;
+        auto middle = (c - b) / 2;
+
+        if (std::abs(middle) <= accuracy || fb == 0)
+        {
+            return true;
+        }
+
+        if (std::abs(e) >= accuracy && std::abs(fa) > std::abs(fb))
+        {
+            // Inverse quadratic interpolation or secant
+            auto s = fb / fa;
+
+            Calculator::NumberType p;
+            Calculator::NumberType q;
+
+            if (a == c)
+            {
+                p = 2 * middle * s;
+                q = 1 - s;
+            }
+            else
+            {
+                auto r = fb / fc;
+
+                q = fa / fc;
+                p = s * (2 * middle * q * (q - r) - (b - a) * (r - 1));
+                q = (q - 1) * (r - 1) * (s - 1);
+            }
+
+            if (p > 0)
+            {
+                q = -q;
+            }
+
+            p = std::abs(p);
+
+            if (2 * p < std::min(3 * middle * q - std::abs(accuracy * q), std::abs(e * q)))
+            {
+                e = d;
+                d = p / q;
+            }
+            else
+            {
+                // Bisection
+                d = middle;
+                e = d;
+            }
+        }
+        else
+        {
+            d = middle;
+            e = d;
+        }
+
+        a = b;
+        fa = fb;
+
+        b += (std::abs(d) > accuracy) ? d : std::copysign(accuracy, middle);
+
+        return false;
+    }
+}
+
+Calculator::DerivativeRule Calculator::getDerivativeRule(const Function* function)
+{
+    switch (getOperation(function))
+    {
+    case Operation::Add:
+        return DerivativeRule::Add;
+    case Operation::Subtract:
+        return DerivativeRule::Subtract;
+    case Operation::Multiply:
+        return DerivativeRule::Multiply;
+    case Operation::Divide:
+        return DerivativeRule::Divide;
+    case Operation::Power:
+        return DerivativeRule::Power;
+    default:
+        break;
+    }
+
+    if (function->contextFunction == &Calculator::evaluatePolynomial)
+    {
+        return DerivativeRule::Polynomial;
+    }
+
+    // Built-in functions are found by implementation,
+    // so own functions with the same names are not
+    // differentiated.
+    static const auto rules = []()
+    {
+        const std::pair<const char*, DerivativeRule> names[] = {
+            {"abs",   DerivativeRule::Abs},
+            {"sin",   DerivativeRule::Sin},
+            {"cos",   DerivativeRule::Cos},
+            {"tan",   DerivativeRule::Tan},
+            {"asin",  DerivativeRule::Asin},
+            {"acos",  DerivativeRule::Acos},
+            {"sinh",  DerivativeRule::Sinh},
+            {"cosh",  DerivativeRule::Cosh},
+            {"tanh",  DerivativeRule::Tanh},
+            {"exp",   DerivativeRule::Exp},
+            {"log",   DerivativeRule::Log},
+            {"log10", DerivativeRule::Log10},
+            {"sqrt",  DerivativeRule::Sqrt},
+            {"ceil",  DerivativeRule::Step},
+            {"floor", DerivativeRule::Step},
+            {">",     DerivativeRule::Step},
+            {"<",     DerivativeRule::Step},
+            {">=",    DerivativeRule::Step},
+            {"<=",    DerivativeRule::Step},
+            {"==",    DerivativeRule::Step},
+            {"!=",    DerivativeRule::Step},
+            {"if",    DerivativeRule::Select}
+        };
+
+        auto functions = sharedFunctions(BasicFunctionSet | LogicFunctionSet);
+
+        std::vector<std::pair<NumberType (*)(ArgumentsStack&), DerivativeRule>> result;
+
+        for (auto&& name : names)
+        {
+            result.emplace_back((*functions)[functions->find(name.first)].function, name.second);
+        }
+
+        return result;
+    }();
+
+    for (auto&& rule : rules)
+    {
+        if (function->function == rule.first)
+        {
+            return rule.second;
+        }
+    }
+
+    return DerivativeRule::None;
+}
+
+void Calculator::differentiate(const Function* function,
+                               const NumberType* values,
+                               NumberType* derivatives,
+                               std::size_t count)
+{
+    auto u = values;
+    auto v = values + BlockSize;
+
+    auto du = derivatives;
+    auto dv = derivatives + BlockSize;
+    auto dw = derivatives + 2 * BlockSize;
+
+    switch (getDerivativeRule(function))
+    {
+    case DerivativeRule::Add:
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            du[i] += dv[i];
+        }
+        break;
+
+    case DerivativeRule::Subtract:
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            du[i] -= dv[i];
+        }
+        break;
+
+    case DerivativeRule::Multiply:
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            du[i] = du[i] * v[i] + u[i] * dv[i];
+        }
+        break;
+
+    case DerivativeRule::Divide:
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            du[i] = (du[i] * v[i] - u[i] * dv[i]) / (v[i] * v[i]);
+        }
+        break;
+
+    case DerivativeRule::Power:
+        // Terms are skipped, if base or exponent is
+        // constant, so `x^2` is differentiable in zero.
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            du[i] = ((du[i] != 0) ? v[i] * std::pow(u[i], v[i] - 1) * du[i] : 0) +
+                    ((dv[i] != 0) ? std::pow(u[i], v[i]) * std::log(u[i]) * dv[i] : 0);
+        }
+        break;
+
+    case DerivativeRule::Polynomial:
+    {
+        auto polynomial = static_cast<const Polynomial*>(function->context);
+        auto& coefficients = polynomial->coefficients;
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            NumberType derivative = 0;
+
+            for (auto k = polynomial->count - 1; k > 0; --k)
+            {
+                derivative = derivative * u[i] + static_cast<NumberType>(k) * coefficients[k];
+            }
+
+            du[i] *= derivative;
+        }
+        break;
+    }
+
+    case DerivativeRule::Abs:
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            du[i] *= (u[i] > 0) ? 1 : ((u[i] < 0) ? -1 : 0);
+        }
+        break;
+
+    case DerivativeRule::Sin:
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            du[i] *= std::cos(u[i]);
+        }
+        break;
+
+    case DerivativeRule::Cos:
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            du[i] *= -std::sin(u[i]);
+        }
+        break;
+
+    case DerivativeRule::Tan:
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            du[i] /= std::cos(u[i]) * std::cos(u[i]);
+        }
+        break;
+
+    case DerivativeRule::Asin:
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            du[i] /= std::sqrt(1 - u[i] * u[i]);
+        }
+        break;
+
+    case DerivativeRule::Acos:
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            du[i] /= -std::sqrt(1 - u[i] * u[i]);
+        }
+        break;
+
+    case DerivativeRule::Sinh:
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            du[i] *= std::cosh(u[i]);
+        }
+        break;
+
+    case DerivativeRule::Cosh:
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            du[i] *= std::sinh(u[i]);
+        }
+        break;
+
+    case DerivativeRule::Tanh:
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            du[i] *= 1 - std::tanh(u[i]) * std::tanh(u[i]);
+        }
+        break;
+
+    case DerivativeRule::Exp:
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            du[i] *= std::exp(u[i]);
+        }
+        break;
+
+    case DerivativeRule::Log:
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            du[i] /= u[i];
+        }
+        break;
+
+    case DerivativeRule::Log10:
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            du[i] /= u[i] * M_LN10;
+        }
+        break;
+
+    case DerivativeRule::Sqrt:
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            du[i] /= 2 * std::sqrt(u[i]);
+        }
+        break;
+
+    case DerivativeRule::Step:
+        std::fill(du, du + count, 0);
+        break;
+
+    case DerivativeRule::Select:
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            du[i] = u[i] ? dv[i] : dw[i];
+        }
+        break;
+
+    default:
+        std::fill(du, du + count, std::numeric_limits<NumberType>::quiet_NaN());
+        break;
+    }
+}
+
+void Calculator::solveBatch(std::string_view variable,
+                            const std::vector<BatchColumn>& columns,
+                            std::size_t rows,
+                            const NumberType* targets,
+                            const SolverOptions& options,
+                            NumberType* roots,
+                            uint32_t* iterations,
+                            SolverStatus* statuses,
+                            std::size_t threads)
+{
+    if (m_expression.empty())
+    {
+        throw StatementException("Unbalanced expression");
+    }
+
+    auto slot = m_variables.find(variable);
+
+    if (slot == m_variables.npos ||
+        std::find(m_programVariables.begin(), m_programVariables.end(), slot) == m_programVariables.end())
+    {
+        throw std::invalid_argument(
+            std::string("Expression does not depend on variable \"")
+                .append(variable.data(), variable.size())
+                .append("\"")
+        );
+    }
+
+    // Columns of other variables by slots
+    std::vector<std::pair<std::size_t, const NumberType*>> parameters;
+
+    // Solved variable is column of roots, so
+    // it's not requested from provider.
+    std::vector<const NumberType*> variableColumns(m_variables.size(), nullptr);
+    variableColumns[slot] = roots;
+
+    for (auto&& column : columns)
+    {
+        auto columnSlot = m_variables.find(column.variable);
+
+        if (columnSlot != m_variables.npos && columnSlot != slot)
+        {
+            parameters.emplace_back(columnSlot, column.values);
+            variableColumns[columnSlot] = column.values;
+        }
+    }
+
+    provideVariables(m_referencedVariables, variableColumns.data());
+
+    for (auto programSlot : m_programVariables)
+    {
+        if (programSlot != slot &&
+            !m_variables[programSlot].defined &&
+            !m_variables[programSlot].provided &&
+            std::none_of(
+                parameters.begin(),
+                parameters.end(),
+                [programSlot](const std::pair<std::size_t, const NumberType*>& parameter)
+                {
+                    return parameter.first == programSlot;
+                }
+            ))
+        {
+            throw CalculationException(
+                std::string("No variable \"")
+                    .append(m_variables.name(programSlot))
+                    .append("\" defined")
+            );
+        }
+    }
+
+    // Reductions are computed once for all rows
+    for (auto&& reduction : m_reductions)
+    {
+        for (auto reductionSlot : reduction.variables)
+        {
+            if (reductionSlot == slot ||
+                std::any_of(
+                    parameters.begin(),
+                    parameters.end(),
+                    [reductionSlot](const std::pair<std::size_t, const NumberType*>& parameter)
+                    {
+                        return parameter.first == reductionSlot;
+                    }
+                ))
+            {
+                throw std::invalid_argument(
+                    std::string("Reduction \"")
+                        .append(reduction.function->name)
+                        .append("\" depends on row variable \"")
+                        .append(m_variables.name(reductionSlot))
+                        .append("\"")
+                );
+            }
+        }
+    }
+
+    auto differentiable = (options.method == SolverMethod::Newton);
+
+    for (auto&& lexem : m_expression)
+    {
+        if (lexem.type != Lexem::Type::Function)
+        {
+            continue;
+        }
+
+        auto function = std::get<const Function*>(lexem.value);
+
+        if (isStream(function))
+        {
+            throw std::invalid_argument(
+                std::string("Stateful function \"")
+                    .append(function->name)
+                    .append("\" can't be solved")
+            );
+        }
+
+        if (getDerivativeRule(function) == DerivativeRule::None)
+        {
+            differentiable = false;
+        }
+    }
+
+    if (!computeReductions())
+    {
+        throw CalculationException("Arrays in reduction have different sizes");
+    }
+
+    auto depth = stackDepth(m_expression);
+    auto chunks = (rows + ChunkSize - 1) / ChunkSize;
+
+    std::atomic<std::size_t> nextChunk(0);
+
+    auto worker = [&]()
+    {
+        SolverWorkspace workspace;
+
+        workspace.batch.stack.resize(depth * BlockSize);
+
+        if (differentiable)
+        {
+            workspace.batch.derivatives.resize(depth * BlockSize);
+        }
+
+        workspace.gathered.resize(parameters.size() * BlockSize);
+        workspace.points.resize(BlockSize);
+        workspace.state.resize(std::max<std::size_t>(BrentStateSize, NewtonStateSize) * BlockSize);
+        workspace.finished.resize(BlockSize);
+
+        // Other variables are broadcast
+        workspace.columns.assign(m_variables.size(), nullptr);
+        workspace.columns[slot] = workspace.points.data();
+
+        for (std::size_t i = 0; i < parameters.size(); ++i)
+        {
+            workspace.columns[parameters[i].first] = workspace.gathered.data() + i * BlockSize;
+        }
+
+        for (auto chunk = nextChunk++; chunk < chunks; chunk = nextChunk++)
+        {
+            auto end = std::min(rows, (chunk + 1) * ChunkSize);
+
+            for (auto begin = chunk * ChunkSize; begin < end; begin += BlockSize)
+            {
+                solveBlock(
+                    m_expression,
+                    slot,
+                    differentiable,
+                    parameters,
+                    begin,
+                    std::min(BlockSize, end - begin),
+                    targets,
+                    options,
+                    roots,
+                    iterations,
+                    statuses,
+                    workspace
+                );
+            }
+        }
+    };
+
+    runParallel(threads, chunks, worker);
+}
+
+void Calculator::solveBlock(const LexemStack& expression,
+                            std::size_t slot,
+                            bool differentiable,
+                            const std::vector<std::pair<std::size_t, const NumberType*>>& columns,
+                            std::size_t begin,
+                            std::size_t count,
+                            const NumberType* targets,
+                            const SolverOptions& options,
+                            NumberType* roots,
+                            uint32_t* iterations,
+                            SolverStatus* statuses,
+                            SolverWorkspace& workspace) const
+{
+    auto& active = workspace.active;
+    auto& points = workspace.points;
+    auto& finished = workspace.finished;
+
+    active.resize(count);
+    std::iota(active.begin(), active.end(), 0);
+
+    std::fill(finished.begin(), finished.begin() + count, 0);
+
+    // Number of active rows, which columns are gathered
+    std::size_t gathered = 0;
+
+    // Computing differences between expression and
+    // targets in points of active rows. They are placed
+    // at start of batch stack.
+    auto evaluate = [&]()
+    {
+        if (gathered != active.size())
+        {
+            for (std::size_t i = 0; i < columns.size(); ++i)
+            {
+                auto values = workspace.gathered.data() + i * BlockSize;
+
+                for (std::size_t j = 0; j < active.size(); ++j)
+                {
+                    values[j] = columns[i].second[begin + active[j]];
+                }
+            }
+
+            gathered = active.size();
+        }
+
+        computeBlock(
+            expression,
+            workspace.columns.data(),
+            0,
+            active.size(),
+            nullptr,
+            workspace.batch,
+            differentiable ? slot : m_variables.npos
+        );
+
+        if (targets)
+        {
+            for (std::size_t i = 0; i < active.size(); ++i)
+            {
+                workspace.batch.stack[i] -= targets[begin + active[i]];
+            }
+        }
+    };
+
+    auto finish = [&](uint32_t row, NumberType root, uint32_t iteration, SolverStatus status)
+    {
+        roots[begin + row] = root;
+
+        if (iterations)
+        {
+            iterations[begin + row] = iteration;
+        }
+
+        if (statuses)
+        {
+            statuses[begin + row] = status;
+        }
+
+        finished[row] = 1;
+    };
+
+    // Converged rows are excluded from evaluation
+    auto compact = [&]()
+    {
+        active.erase(
+            std::remove_if(
+                active.begin(),
+                active.end(),
+                [&finished](uint32_t row)
+                {
+                    return finished[row] != 0;
+                }
+            ),
+            active.end()
+        );
+    };
+
+    auto values = workspace.batch.stack.data();
+
+    if (options.method == SolverMethod::Brent)
+    {
+        std::fill(points.begin(), points.begin() + count, options.lower);
+        evaluate();
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            workspace.state[i * BrentStateSize + BrentFa] = values[i];
+        }
+
+        std::fill(points.begin(), points.begin() + count, options.upper);
+        evaluate();
+
+        for (uint32_t row = 0; row < count; ++row)
+        {
+            auto state = workspace.state.data() + row * BrentStateSize;
+
+            state[BrentA] = options.lower;
+            state[BrentB] = options.upper;
+            state[BrentFb] = values[row];
+            state[BrentC] = state[BrentB];
+            state[BrentFc] = state[BrentFb];
+            state[BrentD] = state[BrentE] = state[BrentB] - state[BrentA];
+
+            if (std::isnan(state[BrentFa]) || std::isnan(state[BrentFb]))
+            {
+                finish(row, state[BrentB], 0, SolverStatus::Failed);
+            }
+            else if (state[BrentFa] == 0)
+            {
+                finish(row, state[BrentA], 0, SolverStatus::Converged);
+            }
+            else if ((state[BrentFa] > 0) == (state[BrentFb] > 0) && state[BrentFb] != 0)
+            {
+                finish(row, state[BrentB], 0, SolverStatus::NoBracket);
+            }
+        }
+
+        compact();
+
+        for (uint32_t iteration = 0; !active.empty(); ++iteration)
+        {
+            for (auto row : active)
+            {
+                auto state = workspace.state.data() + row * BrentStateSize;
+
+                if (brentStep(state, options.tolerance))
+                {
+                    finish(row, state[BrentB], iteration, SolverStatus::Converged);
+                }
+                else if (iteration == options.maxIterations)
+                {
+                    finish(row, state[BrentB], iteration, SolverStatus::MaxIterations);
+                }
+            }
+
+            compact();
+
+            for (std::size_t i = 0; i < active.size(); ++i)
+            {
+                points[i] = workspace.state[active[i] * BrentStateSize + BrentB];
+            }
+
+            evaluate();
+
+            for (std::size_t i = 0; i < active.size(); ++i)
+            {
+                auto state = workspace.state.data() + active[i] * BrentStateSize;
+
+                state[BrentFb] = values[i];
+
+                if (std::isnan(values[i]))
+                {
+                    finish(active[i], state[BrentB], iteration + 1, SolverStatus::Failed);
+                }
+            }
+
+            compact();
+        }
+
+        return;
+    }
+
+    // Newton's method
+    for (uint32_t row = 0; row < count; ++row)
+    {
+        workspace.state[row * NewtonStateSize + NewtonX] = options.initial;
+    }
+
+    if (!differentiable)
+    {
+        // First secant goes through near point
+        auto step = std::sqrt(std::numeric_limits<NumberType>::epsilon()) *
+                    std::max<NumberType>(1, std::abs(options.initial));
+
+        std::fill(points.begin(), points.begin() + count, options.initial + step);
+        evaluate();
+
+        for (std::size_t row = 0; row < count; ++row)
+        {
+            workspace.state[row * NewtonStateSize + NewtonPreviousX] = options.initial + step;
+            workspace.state[row * NewtonStateSize + NewtonPreviousValue] = values[row];
+        }
+    }
+
+    auto derivatives = workspace.batch.derivatives.data();
+
+    for (uint32_t iteration = 1; !active.empty(); ++iteration)
+    {
+        for (std::size_t i = 0; i < active.size(); ++i)
+        {
+            points[i] = workspace.state[active[i] * NewtonStateSize + NewtonX];
+        }
+
+        evaluate();
+
+        for (std::size_t i = 0; i < active.size(); ++i)
+        {
+            auto row = active[i];
+            auto state = workspace.state.data() + row * NewtonStateSize;
+
+            auto x = state[NewtonX];
+            auto value = values[i];
+
+            if (value == 0)
+            {
+                finish(row, x, iteration, SolverStatus::Converged);
+                continue;
+            }
+
+            auto slope = differentiable ?
+                derivatives[i] :
+                (value - state[NewtonPreviousValue]) / (x - state[NewtonPreviousX]);
+
+            auto step = value / slope;
+
+            if (!std::isfinite(value) || !std::isfinite(step))
+            {
+                finish(row, x, iteration, SolverStatus::Failed);
+                continue;
+            }
+
+            state[NewtonPreviousX] = x;
+            state[NewtonPreviousValue] = value;
+            state[NewtonX] = x - step;
+
+            if (std::abs(step) <= options.tolerance)
+            {
+                finish(row, state[NewtonX], iteration, SolverStatus::Converged);
+            }
+            else if (iteration == options.maxIterations)
+            {
+                finish(row, state[NewtonX], iteration, SolverStatus::MaxIterations);
+            }
+        }
+
+        compact();
+    }
+}
\ No newline at end of file
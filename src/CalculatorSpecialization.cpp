@@ -0,0 +1,85 @@
+#include <algorithm>
+#include <stdexcept>
+#include "Calculator.hpp"
+
+void Calculator::specialize(const std::vector<std::string_view>& variables)
+{
+    if (m_expression.empty())
+    {
+        throw StatementException("Unbalanced expression");
+    }
+
+    std::vector<std::size_t> slots;
+
+    for (auto&& name : variables)
+    {
+        auto slot = m_variables.find(name);
+
+        if (slot == m_variables.npos ||
+            !m_variables[slot].defined)
+        {
+            throw std::invalid_argument(
+                std::string("There is no variable \"")
+                    .append(name.data(), name.size())
+                    .append("\"")
+            );
+        }
+
+        if (m_variables[slot].array)
+        {
+            throw std::invalid_argument(
+                std::string("Array variable \"")
+                    .append(name.data(), name.size())
+                    .append("\" can't be specialized")
+            );
+        }
+
+        slots.push_back(slot);
+    }
+
+    if (m_generalExpression.empty())
+    {
+        m_generalExpression = m_expression;
+        m_generalPolynomials = m_polynomials.size();
+    }
+    else
+    {
+        m_expression = m_generalExpression;
+        m_polynomials.resize(m_generalPolynomials);
+    }
+
+    for (auto&& lexem : m_expression)
+    {
+        if (lexem.type == Lexem::Type::Variable &&
+            std::find(slots.begin(), slots.end(), std::get<std::size_t>(lexem.value)) != slots.end())
+        {
+            lexem = Lexem(
+                Lexem::Type::Constant,
+                m_variables[std::get<std::size_t>(lexem.value)].value
+            );
+        }
+    }
+
+    performOptimization();
+    detectPolynomials();
+
+    buildProgram();
+    resetProfile();
+}
+
+void Calculator::generalize()
+{
+    if (m_generalExpression.empty())
+    {
+        return;
+    }
+
+    m_expression = std::move(m_generalExpression);
+    m_generalExpression.clear();
+
+    // Polynomials of specialized expression
+    m_polynomials.resize(m_generalPolynomials);
+
+    buildProgram();
+    resetProfile();
+}
\ No newline at end of file
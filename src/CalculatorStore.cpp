@@ -0,0 +1,146 @@
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include <CalculationException.hpp>
+#include <SerializationException.hpp>
+#include "Calculator.hpp"
+
+void Calculator::bindStore(const ExpressionStore& store)
+{
+    std::vector<const Function*> functions(store.header().functionsCount);
+
+    for (std::size_t i = 0; i < functions.size(); ++i)
+    {
+        auto& stored = store.function(i);
+        auto name = store.string(stored);
+
+        auto searchResult = m_functions.find(name);
+
+        if (searchResult == m_functions.npos)
+        {
+            throw SerializationException(
+                std::string("Expression store references unknown function \"")
+                    .append(name.data(), name.size())
+                    .append("\"")
+            );
+        }
+
+        if (std::as_const(m_functions)[searchResult].numberOfArguments != stored.numberOfArguments)
+        {
+            throw SerializationException(
+                std::string("Function \"")
+                    .append(name.data(), name.size())
+                    .append("\" has different number of arguments")
+            );
+        }
+
+        // Store is shared, so it has no state
+        if (isStream(&std::as_const(m_functions)[searchResult]))
+        {
+            throw SerializationException(
+                std::string("Stateful function \"")
+                    .append(name.data(), name.size())
+                    .append("\" can't be executed from store")
+            );
+        }
+
+        functions[i] = &std::as_const(m_functions)[searchResult];
+    }
+
+    m_storeVariables.resize(store.header().variablesCount);
+
+    for (std::size_t i = 0; i < m_storeVariables.size(); ++i)
+    {
+        m_storeVariables[i] = m_variables.intern(store.string(store.variable(i)));
+    }
+
+    // Variables of expressions are requested from
+    // provider without allocations on execution.
+    m_storeReferences.assign(store.size(), {});
+
+    for (std::size_t i = 0; i < store.size(); ++i)
+    {
+        auto& stored = store.expression(i);
+        auto& references = m_storeReferences[i];
+
+        auto program = store.at<ExpressionStore::Instruction>(stored.programOffset);
+
+        for (auto instruction = program; instruction != program + stored.programSize; ++instruction)
+        {
+            if (static_cast<Lexem::Type>(instruction->type) != Lexem::Type::Variable)
+            {
+                continue;
+            }
+
+            auto slot = m_storeVariables[instruction->index];
+
+            if (std::find(references.begin(), references.end(), slot) == references.end())
+            {
+                references.push_back(slot);
+            }
+        }
+
+        m_variableRequests.reserve(references.size());
+        m_requestedSlots.reserve(references.size());
+    }
+
+    m_storeFunctions = std::move(functions);
+    m_store = &store;
+
+    m_executionStack.reserve(store.stackDepth());
+}
+
+Calculator::NumberType Calculator::executeStored(std::size_t index)
+{
+    if (m_store == nullptr || index >= m_store->size())
+    {
+        throw std::invalid_argument("There is no stored expression with this index");
+    }
+
+    auto& stored = m_store->expression(index);
+
+    // Store is validated on opening, so
+    // program is balanced.
+    auto constants = m_store->at<NumberType>(stored.constantsOffset);
+    auto program = m_store->at<ExpressionStore::Instruction>(stored.programOffset);
+
+    provideVariables(m_storeReferences[index], nullptr);
+
+    m_executionStack.clear();
+
+    for (auto instruction = program; instruction != program + stored.programSize; ++instruction)
+    {
+        switch (static_cast<Lexem::Type>(instruction->type))
+        {
+        case Lexem::Type::Constant:
+            m_executionStack.push_back(constants[instruction->index]);
+            break;
+
+        case Lexem::Type::Variable:
+        {
+            auto slot = m_storeVariables[instruction->index];
+            auto& variable = m_variables[slot];
+
+            if (!variable.defined && !variable.provided)
+            {
+                throw CalculationException(
+                    std::string("No variable \"")
+                        .append(m_variables.name(slot))
+                        .append("\" defined")
+                );
+            }
+
+            m_executionStack.push_back(variable.value);
+            break;
+        }
+
+        default:
+            m_executionStack.push_back(
+                m_storeFunctions[instruction->index]->call(m_executionStack)
+            );
+            break;
+        }
+    }
+
+    return m_executionStack.back();
+}
\ No newline at end of file
@@ -0,0 +1,158 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <StatementException.hpp>
+#include "Calculator.hpp"
+
+void Calculator::addStreamFunctions()
+{
+    addFunction(Calculator::Function("prev",         1, 4, &Calculator::streamPrev,        nullptr));
+    addFunction(Calculator::Function("ema",          2, 4, &Calculator::streamEma,         nullptr));
+    addFunction(Calculator::Function("rolling_sum",  2, 4, &Calculator::streamRollingSum,  nullptr));
+    addFunction(Calculator::Function("rolling_mean", 2, 4, &Calculator::streamRollingMean, nullptr));
+}
+
+void Calculator::resetStreams()
+{
+    for (auto&& stream : m_streams)
+    {
+        stream.value = std::numeric_limits<NumberType>::quiet_NaN();
+        stream.count = 0;
+        stream.position = 0;
+        stream.sum = 0;
+
+        std::fill(stream.window.begin(), stream.window.end(), 0);
+    }
+}
+
+bool Calculator::isStream(const Function* function)
+{
+    return isRandom(function) ||
+           function->contextFunction == &Calculator::streamPrev ||
+           function->contextFunction == &Calculator::streamEma ||
+           function->contextFunction == &Calculator::streamRollingSum ||
+           function->contextFunction == &Calculator::streamRollingMean;
+}
+
+void Calculator::instantiateStreams()
+{
+    uint32_t randomSites = 0;
+
+    for (std::size_t i = 0; i < m_expression.size(); ++i)
+    {
+        auto& lexem = m_expression[i];
+
+        if (lexem.type != Lexem::Type::Function ||
+            !isStream(std::get<const Function*>(lexem.value)))
+        {
+            continue;
+        }
+
+        auto function = std::get<const Function*>(lexem.value);
+
+        m_streams.push_back({Function(), 0, 0, {}, 0, 0, m_randomSeed, 0});
+
+        auto& stream = m_streams.back();
+
+        stream.function = *function;
+        stream.function.context = &stream;
+
+        if (function->contextFunction == &Calculator::streamRollingSum ||
+            function->contextFunction == &Calculator::streamRollingMean)
+        {
+            // Window is last argument, so it's
+            // previous lexem.
+            auto& window = m_expression[i - 1];
+
+            if (window.type != Lexem::Type::Constant ||
+                !(std::get<NumberType>(window.value) >= 1) ||
+                std::get<NumberType>(window.value) != std::floor(std::get<NumberType>(window.value)))
+            {
+                throw StatementException(
+                    std::string("Window of \"")
+                        .append(function->name)
+                        .append("\" is not positive integer constant")
+                );
+            }
+
+            stream.window.resize(static_cast<std::size_t>(std::get<NumberType>(window.value)));
+        }
+
+        if (isRandom(function))
+        {
+            stream.site = randomSites++;
+        }
+
+        lexem.value = &stream.function;
+    }
+
+    resetStreams();
+}
+
+Calculator::NumberType Calculator::streamPrev(ArgumentsStack& stack, void* context)
+{
+    auto& stream = *static_cast<Stream*>(context);
+
+    auto value = stack.back();
+    stack.pop_back();
+
+    auto previous = stream.value;
+    stream.value = value;
+
+    return previous;
+}
+
+Calculator::NumberType Calculator::streamEma(ArgumentsStack& stack, void* context)
+{
+    auto& stream = *static_cast<Stream*>(context);
+
+    auto alpha = stack.back();
+    stack.pop_back();
+
+    auto value = stack.back();
+    stack.pop_back();
+
+    stream.value = (stream.count++ == 0) ?
+        value :
+        stream.value + alpha * (value - stream.value);
+
+    return stream.value;
+}
+
+Calculator::NumberType Calculator::streamRollingSum(ArgumentsStack& stack, void* context)
+{
+    auto& stream = *static_cast<Stream*>(context);
+
+    // Window size is known from compilation
+    stack.pop_back();
+
+    auto value = stack.back();
+    stack.pop_back();
+
+    // Empty window places are zeros
+    auto& oldest = stream.window[stream.position];
+
+    stream.sum += value - oldest;
+    oldest = value;
+
+    if (++stream.position == stream.window.size())
+    {
+        stream.position = 0;
+
+        // Sum is recomputed once per window, so rounding
+        // errors and passed NaN are not kept.
+        stream.sum = std::accumulate(stream.window.begin(), stream.window.end(), NumberType(0));
+    }
+
+    stream.count = std::min(stream.count + 1, stream.window.size());
+
+    return stream.sum;
+}
+
+Calculator::NumberType Calculator::streamRollingMean(ArgumentsStack& stack, void* context)
+{
+    auto sum = streamRollingSum(stack, context);
+
+    return sum / static_cast<NumberType>(static_cast<Stream*>(context)->count);
+}
\ No newline at end of file
@@ -0,0 +1,257 @@
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include "Calculator.hpp"
+
+namespace
+{
+    // Number of grid points, that are computed at once.
+    const std::size_t BlockSize = 256;
+}
+
+void Calculator::buildSweepTerms(const std::vector<std::size_t>& levels, std::vector<SweepTerm>& terms) const
+{
+    // Subexpressions of values on stack
+    std::vector<SweepTerm> stack;
+
+    // Argument of outer loop is moved into own term
+    // and replaced with constant in expression.
+    auto hoist = [&terms](SweepTerm& argument)
+    {
+        // Single constants and variables without
+        // axes are computed in place.
+        if (argument.level == 0 && argument.expression.size() == 1)
+        {
+            return;
+        }
+
+        terms.push_back(std::move(argument));
+
+        argument = SweepTerm(terms.back().level);
+        argument.expression.emplace_back(Lexem::Type::Constant, NumberType(0));
+        argument.arguments.emplace_back(0, terms.size() - 1);
+    };
+
+    for (auto&& lexem : m_expression)
+    {
+        if (lexem.type != Lexem::Type::Function)
+        {
+            std::size_t level = 0;
+
+            if (lexem.type == Lexem::Type::Variable)
+            {
+                level = levels[std::get<std::size_t>(lexem.value)];
+            }
+
+            stack.emplace_back(level);
+            stack.back().expression.push_back(lexem);
+
+            continue;
+        }
+
+        auto first = stack.size() - std::get<const Function*>(lexem.value)->numberOfArguments;
+
+        std::size_t level = 0;
+
+        for (auto argument = stack.begin() + static_cast<std::ptrdiff_t>(first); argument != stack.end(); ++argument)
+        {
+            level = std::max(level, argument->level);
+        }
+
+        SweepTerm term(level);
+
+        for (auto argument = stack.begin() + static_cast<std::ptrdiff_t>(first); argument != stack.end(); ++argument)
+        {
+            if (argument->level < level)
+            {
+                hoist(*argument);
+            }
+
+            for (auto&& position : argument->arguments)
+            {
+                term.arguments.emplace_back(term.expression.size() + position.first, position.second);
+            }
+
+            term.expression.insert(term.expression.end(), argument->expression.begin(), argument->expression.end());
+        }
+
+        term.expression.push_back(lexem);
+
+        stack.erase(stack.begin() + static_cast<std::ptrdiff_t>(first), stack.end());
+        stack.push_back(std::move(term));
+    }
+
+    terms.push_back(std::move(stack.back()));
+}
+
+void Calculator::sweep(const std::vector<SweepAxis>& axes, NumberType* results)
+{
+    if (m_expression.empty())
+    {
+        throw StatementException("Unbalanced expression");
+    }
+
+    // Loop levels of variables. Axis `i` is level `i + 1`.
+    std::vector<std::size_t> levels(m_variables.size(), 0);
+
+    std::vector<const NumberType*> columns(m_variables.size(), nullptr);
+
+    for (std::size_t i = 0; i < axes.size(); ++i)
+    {
+        for (std::size_t j = 0; j < i; ++j)
+        {
+            if (axes[j].variable == axes[i].variable)
+            {
+                throw std::invalid_argument(
+                    std::string("Variable \"")
+                        .append(axes[i].variable.data(), axes[i].variable.size())
+                        .append("\" has several axes")
+                );
+            }
+        }
+
+        if (axes[i].count == 0)
+        {
+            return;
+        }
+
+        auto slot = m_variables.find(axes[i].variable);
+
+        // Expression doesn't depend on variable
+        if (slot == m_variables.npos)
+        {
+            continue;
+        }
+
+        levels[slot] = i + 1;
+        columns[slot] = axes[i].values;
+    }
+
+    provideVariables(m_referencedVariables, columns.data());
+
+    for (auto slot : m_programVariables)
+    {
+        if (levels[slot] == 0 &&
+            !m_variables[slot].defined &&
+            !m_variables[slot].provided)
+        {
+            throw CalculationException(
+                std::string("No variable \"")
+                    .append(m_variables.name(slot))
+                    .append("\" defined")
+            );
+        }
+    }
+
+    for (auto&& lexem : m_expression)
+    {
+        if (lexem.type == Lexem::Type::Function &&
+            isStream(std::get<const Function*>(lexem.value)))
+        {
+            throw std::invalid_argument(
+                std::string("Stateful function \"")
+                    .append(std::get<const Function*>(lexem.value)->name)
+                    .append("\" can't be swept")
+            );
+        }
+    }
+
+    // Reductions are computed once before sweep
+    for (auto&& reduction : m_reductions)
+    {
+        for (auto slot : reduction.variables)
+        {
+            if (levels[slot] != 0)
+            {
+                throw std::invalid_argument(
+                    std::string("Reduction \"")
+                        .append(reduction.function->name)
+                        .append("\" depends on swept variable \"")
+                        .append(m_variables.name(slot))
+                        .append("\"")
+                );
+            }
+        }
+    }
+
+    if (!computeReductions())
+    {
+        throw CalculationException("Arrays in reduction have different sizes");
+    }
+
+    std::vector<SweepTerm> terms;
+    buildSweepTerms(levels, terms);
+
+    std::size_t depth = 0;
+
+    for (auto&& term : terms)
+    {
+        depth = std::max(depth, stackDepth(term.expression));
+    }
+
+    m_batchWorkspace.stack.resize(depth * BlockSize);
+
+    // Current indices of loops by levels
+    std::vector<std::size_t> indices(axes.size() + 1, 0);
+
+    auto& expression = terms.back();
+
+    // Terms of level are computed for all values of
+    // its variable, when outer loops change.
+    std::function<void(std::size_t)> sweepLevel = [&](std::size_t level)
+    {
+        auto count = (level == 0) ? 1 : axes[level - 1].count;
+
+        for (auto&& term : terms)
+        {
+            if (term.level != level)
+            {
+                continue;
+            }
+
+            for (auto&& argument : term.arguments)
+            {
+                auto& outer = terms[argument.second];
+
+                term.expression[argument.first].value = outer.values[indices[outer.level]];
+            }
+
+            term.values.resize(count);
+
+            for (std::size_t offset = 0; offset < count; offset += BlockSize)
+            {
+                auto blockCount = std::min(BlockSize, count - offset);
+
+                computeBlock(term.expression, columns.data(), offset, blockCount, nullptr);
+
+                std::copy(
+                    m_batchWorkspace.stack.begin(),
+                    m_batchWorkspace.stack.begin() + static_cast<std::ptrdiff_t>(blockCount),
+                    term.values.begin() + static_cast<std::ptrdiff_t>(offset)
+                );
+            }
+        }
+
+        if (level == axes.size())
+        {
+            if (expression.level == level)
+            {
+                results = std::copy(expression.values.begin(), expression.values.end(), results);
+            }
+            else
+            {
+                results = std::fill_n(results, count, expression.values[indices[expression.level]]);
+            }
+
+            return;
+        }
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            indices[level] = i;
+            sweepLevel(level + 1);
+        }
+    };
+
+    sweepLevel(0);
+}
\ No newline at end of file
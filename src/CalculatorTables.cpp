@@ -0,0 +1,207 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <CalculationException.hpp>
+#include "Calculator.hpp"
+
+void Calculator::addInterpolationFunctions()
+{
+    addFunction(Calculator::Function("interp",       2, 4, &Calculator::interpolateLinear, &m_tables));
+    addFunction(Calculator::Function("interp_step",  2, 4, &Calculator::interpolateStep,   &m_tables));
+    addFunction(Calculator::Function("interp_cubic", 2, 4, &Calculator::interpolateCubic,  &m_tables));
+}
+
+void Calculator::addTable(std::string_view name,
+                          std::vector<NumberType> x,
+                          std::vector<NumberType> y)
+{
+    if (x.size() != y.size())
+    {
+        throw std::invalid_argument("Table points and values have different sizes");
+    }
+
+    if (x.size() < 2)
+    {
+        throw std::invalid_argument("Table needs at least two points");
+    }
+
+    for (std::size_t i = 0; i + 1 < x.size(); ++i)
+    {
+        if (!(x[i] < x[i + 1]))
+        {
+            throw std::invalid_argument("Table points are not increasing");
+        }
+    }
+
+    auto count = x.size();
+
+    Table table = {};
+
+    table.step = (x.back() - x.front()) / static_cast<NumberType>(count - 1);
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        if (std::abs(x[i] - (x.front() + static_cast<NumberType>(i) * table.step)) > table.step * 1e-9)
+        {
+            table.step = 0;
+            break;
+        }
+    }
+
+    // Natural spline, tridiagonal system is
+    // solved by sweep.
+    std::vector<NumberType> sweep(count, 0);
+
+    table.curvatures.assign(count, 0);
+
+    for (std::size_t i = 1; i + 1 < count; ++i)
+    {
+        auto ratio = (x[i] - x[i - 1]) / (x[i + 1] - x[i - 1]);
+        auto pivot = ratio * table.curvatures[i - 1] + 2;
+
+        auto slopes = (y[i + 1] - y[i]) / (x[i + 1] - x[i]) -
+                      (y[i] - y[i - 1]) / (x[i] - x[i - 1]);
+
+        table.curvatures[i] = (ratio - 1) / pivot;
+        sweep[i] = (6 * slopes / (x[i + 1] - x[i - 1]) - ratio * sweep[i - 1]) / pivot;
+    }
+
+    for (std::size_t i = count - 1; i-- > 0;)
+    {
+        table.curvatures[i] = table.curvatures[i] * table.curvatures[i + 1] + sweep[i];
+    }
+
+    table.x = std::move(x);
+    table.y = std::move(y);
+
+    addConstant(name, static_cast<NumberType>(m_tables.insert(name, std::move(table))));
+}
+
+const Calculator::Table& Calculator::popTable(ArgumentsStack& stack, void* context, NumberType& point)
+{
+    point = stack.back();
+    stack.pop_back();
+
+    auto index = stack.back();
+    stack.pop_back();
+
+    auto& tables = *static_cast<SymbolTable<Table>*>(context);
+
+    if (!(index >= 0) ||
+        index >= static_cast<NumberType>(tables.size()) ||
+        index != std::floor(index))
+    {
+        throw CalculationException("Unknown table");
+    }
+
+    return tables[static_cast<std::size_t>(index)];
+}
+
+std::size_t Calculator::findSegment(const Table& table, NumberType point)
+{
+    auto last = table.x.size() - 2;
+
+    if (table.step > 0)
+    {
+        auto position = (point - table.x.front()) / table.step;
+
+        if (!(position > 0))
+        {
+            return 0;
+        }
+
+        if (position >= static_cast<NumberType>(last))
+        {
+            return last;
+        }
+
+        auto segment = static_cast<std::size_t>(position);
+
+        // Grid is uniform up to rounding
+        if (point < table.x[segment] && segment > 0)
+        {
+            --segment;
+        }
+        else if (point >= table.x[segment + 1] && segment < last)
+        {
+            ++segment;
+        }
+
+        return segment;
+    }
+
+    // Binary search without branches, so
+    // there are no mispredictions.
+    auto base = table.x.data();
+    auto count = last + 1;
+
+    while (count > 1)
+    {
+        auto half = count / 2;
+
+        base = (base[half] <= point) ? base + half : base;
+        count -= half;
+    }
+
+    return static_cast<std::size_t>(base - table.x.data());
+}
+
+Calculator::NumberType Calculator::interpolateLinear(ArgumentsStack& stack, void* context)
+{
+    NumberType point;
+
+    auto& table = popTable(stack, context, point);
+
+    if (std::isnan(point))
+    {
+        return point;
+    }
+
+    auto i = findSegment(table, point);
+
+    auto t = std::clamp((point - table.x[i]) / (table.x[i + 1] - table.x[i]), 0.0, 1.0);
+
+    return table.y[i] + (table.y[i + 1] - table.y[i]) * t;
+}
+
+Calculator::NumberType Calculator::interpolateStep(ArgumentsStack& stack, void* context)
+{
+    NumberType point;
+
+    auto& table = popTable(stack, context, point);
+
+    if (std::isnan(point))
+    {
+        return point;
+    }
+
+    if (point >= table.x.back())
+    {
+        return table.y.back();
+    }
+
+    return table.y[findSegment(table, point)];
+}
+
+Calculator::NumberType Calculator::interpolateCubic(ArgumentsStack& stack, void* context)
+{
+    NumberType point;
+
+    auto& table = popTable(stack, context, point);
+
+    if (std::isnan(point))
+    {
+        return point;
+    }
+
+    auto i = findSegment(table, point);
+
+    auto h = table.x[i + 1] - table.x[i];
+    auto b = std::clamp((point - table.x[i]) / h, 0.0, 1.0);
+    auto a = 1 - b;
+
+    return a * table.y[i] +
+           b * table.y[i + 1] +
+           ((a * a * a - a) * table.curvatures[i] +
+            (b * b * b - b) * table.curvatures[i + 1]) * h * h / 6;
+}
\ No newline at end of file
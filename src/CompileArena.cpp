@@ -0,0 +1,163 @@
+#include <algorithm>
+#include <cstdint>
+#include "CompileArena.hpp"
+
+namespace
+{
+    const std::size_t MinimalBlockSize = 4096;
+    const std::size_t BlockAlignment = alignof(std::max_align_t);
+}
+
+CompileArena::CompileArena(std::pmr::memory_resource* upstream) :
+    m_upstream(upstream),
+    m_blocks(),
+    m_currentBlock(0),
+    m_offset(0)
+{
+
+}
+
+CompileArena::CompileArena(const CompileArena& rhs) :
+    std::pmr::memory_resource(rhs),
+    m_upstream(rhs.m_upstream),
+    m_blocks(),
+    m_currentBlock(0),
+    m_offset(0)
+{
+
+}
+
+CompileArena::~CompileArena()
+{
+    release();
+}
+
+CompileArena& CompileArena::operator=(const CompileArena& rhs)
+{
+    if (this != &rhs)
+    {
+        setUpstream(rhs.m_upstream);
+    }
+
+    return *this;
+}
+
+void CompileArena::reset()
+{
+    if (m_blocks.size() > 1)
+    {
+        // Merging blocks, so next compilation
+        // fits into one block.
+        std::size_t size = 0;
+
+        for (auto&& block : m_blocks)
+        {
+            size += block.size;
+        }
+
+        release();
+
+        m_blocks.push_back(
+            Block{
+                static_cast<std::byte*>(m_upstream->allocate(size, BlockAlignment)),
+                size
+            }
+        );
+    }
+
+    m_currentBlock = 0;
+    m_offset = 0;
+}
+
+void CompileArena::setUpstream(std::pmr::memory_resource* upstream)
+{
+    release();
+
+    m_upstream = upstream;
+}
+
+std::pmr::memory_resource* CompileArena::upstream() const
+{
+    return m_upstream;
+}
+
+std::size_t CompileArena::capacity() const
+{
+    std::size_t size = 0;
+
+    for (auto&& block : m_blocks)
+    {
+        size += block.size;
+    }
+
+    return size;
+}
+
+void* CompileArena::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+    while (m_currentBlock < m_blocks.size())
+    {
+        auto& block = m_blocks[m_currentBlock];
+
+        auto address = reinterpret_cast<std::uintptr_t>(block.data);
+        auto offset = (address + m_offset + alignment - 1) / alignment * alignment - address;
+
+        if (offset + bytes <= block.size)
+        {
+            m_offset = offset + bytes;
+
+            return block.data + offset;
+        }
+
+        ++m_currentBlock;
+        m_offset = 0;
+    }
+
+    // Allocating new block, that's at least twice
+    // bigger than previous one.
+    auto size = std::max(
+        MinimalBlockSize,
+        bytes + std::max(alignment, BlockAlignment)
+    );
+
+    if (!m_blocks.empty())
+    {
+        size = std::max(size, m_blocks.back().size * 2);
+    }
+
+    m_blocks.push_back(
+        Block{
+            static_cast<std::byte*>(m_upstream->allocate(size, BlockAlignment)),
+            size
+        }
+    );
+
+    m_currentBlock = m_blocks.size() - 1;
+    m_offset = 0;
+
+    return do_allocate(bytes, alignment);
+}
+
+void CompileArena::do_deallocate(void* /* pointer */,
+                                 std::size_t /* bytes */,
+                                 std::size_t /* alignment */)
+{
+    // Memory is freed on reset
+}
+
+bool CompileArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+    return this == &other;
+}
+
+void CompileArena::release()
+{
+    for (auto&& block : m_blocks)
+    {
+        m_upstream->deallocate(block.data, block.size, BlockAlignment);
+    }
+
+    m_blocks.clear();
+    m_currentBlock = 0;
+    m_offset = 0;
+}
\ No newline at end of file
@@ -0,0 +1,169 @@
+#include <algorithm>
+#include <ostream>
+#include "CompileTrace.hpp"
+
+namespace
+{
+    void writeEscaped(std::ostream& stream, std::string_view string)
+    {
+        const char* hex = "0123456789abcdef";
+
+        for (auto c : string)
+        {
+            switch (c)
+            {
+            case '"':
+                stream << "\\\"";
+                break;
+            case '\\':
+                stream << "\\\\";
+                break;
+            case '\n':
+                stream << "\\n";
+                break;
+            case '\t':
+                stream << "\\t";
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    stream << "\\u00" << hex[(c >> 4) & 0xF] << hex[c & 0xF];
+                }
+                else
+                {
+                    stream << c;
+                }
+                break;
+            }
+        }
+    }
+
+    // Trace event timestamps are in microseconds
+    double microseconds(std::chrono::nanoseconds time)
+    {
+        return time.count() / 1000.0;
+    }
+
+    void writeEvent(std::ostream& stream,
+                    std::string_view name,
+                    std::string_view category,
+                    std::chrono::nanoseconds start,
+                    std::chrono::nanoseconds duration,
+                    uint32_t thread)
+    {
+        stream << "{\"name\":\"";
+        writeEscaped(stream, name);
+        stream << "\",\"cat\":\"" << category
+               << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread
+               << ",\"ts\":" << microseconds(start)
+               << ",\"dur\":" << microseconds(duration);
+    }
+}
+
+CompileTrace::CompileTrace() :
+    m_compilations()
+{
+
+}
+
+void CompileTrace::addCompilation(std::string_view name,
+                                  const Calculator::CompileStatistics& statistics,
+                                  uint32_t thread)
+{
+    m_compilations.push_back(Compilation{std::string(name), statistics, thread});
+}
+
+void CompileTrace::clear()
+{
+    m_compilations.clear();
+}
+
+void CompileTrace::write(std::ostream& stream) const
+{
+    using Statistics = Calculator::CompileStatistics;
+
+    static const std::pair<const char*, std::chrono::nanoseconds Statistics::*> phases[] = {
+        {"splitOnLexems",       &Statistics::splittingTime},
+        {"pushLexems",          &Statistics::pushingTime},
+        {"performValidation",   &Statistics::validationTime},
+        {"performOptimization", &Statistics::optimizationTime},
+        {"buildProgram",        &Statistics::programTime}
+    };
+
+    std::chrono::steady_clock::time_point origin;
+
+    if (!m_compilations.empty())
+    {
+        origin = std::min_element(
+            m_compilations.begin(),
+            m_compilations.end(),
+            [](const Compilation& lhs, const Compilation& rhs)
+            {
+                return lhs.statistics.startTime < rhs.statistics.startTime;
+            }
+        )->statistics.startTime;
+    }
+
+    auto precision = stream.precision(3);
+    auto flags = stream.setf(std::ios::fixed, std::ios::floatfield);
+
+    stream << "{\"traceEvents\":[";
+
+    bool first = true;
+
+    for (auto&& compilation : m_compilations)
+    {
+        auto& statistics = compilation.statistics;
+
+        auto start = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            statistics.startTime - origin
+        );
+
+        std::chrono::nanoseconds total(0);
+
+        for (auto&& phase : phases)
+        {
+            total += statistics.*phase.second;
+        }
+
+        if (!first)
+        {
+            stream << ',';
+        }
+
+        first = false;
+
+        writeEvent(stream, compilation.name, "compilation", start, total, compilation.thread);
+
+        stream << ",\"args\":{"
+               << "\"lexems\":" << statistics.lexemsCount
+               << ",\"rpnLength\":" << statistics.rpnLength
+               << ",\"optimizedLength\":" << statistics.optimizedLength
+               << ",\"instructions\":" << statistics.instructionsCount
+               << ",\"folds\":" << statistics.foldsCount
+               << ",\"maxStackDepth\":" << statistics.maxStackDepth
+               << "}}";
+
+        // Phases are going one after another
+        for (auto&& phase : phases)
+        {
+            auto duration = statistics.*phase.second;
+
+            if (duration.count() == 0)
+            {
+                continue;
+            }
+
+            stream << ',';
+            writeEvent(stream, phase.first, "phase", start, duration, compilation.thread);
+            stream << '}';
+
+            start += duration;
+        }
+    }
+
+    stream << "],\"displayTimeUnit\":\"ns\"}";
+
+    stream.precision(precision);
+    stream.flags(flags);
+}
\ No newline at end of file
@@ -0,0 +1,239 @@
+#include <algorithm>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <SerializationException.hpp>
+#include "ExpressionStore.hpp"
+#include "Calculator.hpp"
+
+ExpressionStore::ExpressionStore(const std::string& path) :
+    m_data(nullptr),
+    m_size(0),
+    m_mapped(false),
+    m_stackDepth(0)
+{
+    auto descriptor = open(path.c_str(), O_RDONLY);
+
+    if (descriptor < 0)
+    {
+        throw SerializationException(
+            std::string("Can't open expression store \"")
+                .append(path)
+                .append("\"")
+        );
+    }
+
+    struct stat status = {};
+
+    if (fstat(descriptor, &status) != 0 ||
+        status.st_size < static_cast<off_t>(sizeof(Header)))
+    {
+        close(descriptor);
+        throw SerializationException("Data is not an expression store");
+    }
+
+    m_size = static_cast<std::size_t>(status.st_size);
+
+    // Pages of file are shared by all processes,
+    // that map it.
+    auto data = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, descriptor, 0);
+
+    close(descriptor);
+
+    if (data == MAP_FAILED)
+    {
+        throw SerializationException("Can't map expression store");
+    }
+
+    m_data = static_cast<const unsigned char*>(data);
+    m_mapped = true;
+
+    try
+    {
+        validate();
+    }
+    catch (...)
+    {
+        munmap(data, m_size);
+        throw;
+    }
+}
+
+ExpressionStore::ExpressionStore(const void* data, std::size_t size) :
+    m_data(static_cast<const unsigned char*>(data)),
+    m_size(size),
+    m_mapped(false),
+    m_stackDepth(0)
+{
+    if (reinterpret_cast<uintptr_t>(data) % alignof(uint64_t) != 0)
+    {
+        throw std::invalid_argument("Expression store is not aligned");
+    }
+
+    validate();
+}
+
+ExpressionStore::~ExpressionStore()
+{
+    if (m_mapped)
+    {
+        munmap(const_cast<unsigned char*>(m_data), m_size);
+    }
+}
+
+std::size_t ExpressionStore::size() const
+{
+    return header().expressionsCount;
+}
+
+std::size_t ExpressionStore::stackDepth() const
+{
+    return m_stackDepth;
+}
+
+const ExpressionStore::Header& ExpressionStore::header() const
+{
+    return *at<Header>(0);
+}
+
+const ExpressionStore::Expression& ExpressionStore::expression(std::size_t index) const
+{
+    return at<Expression>(header().expressionsOffset)[index];
+}
+
+const ExpressionStore::Name& ExpressionStore::variable(std::size_t index) const
+{
+    return at<Name>(header().variablesOffset)[index];
+}
+
+const ExpressionStore::Name& ExpressionStore::function(std::size_t index) const
+{
+    return at<Name>(header().functionsOffset)[index];
+}
+
+std::string_view ExpressionStore::string(const Name& name) const
+{
+    return std::string_view(at<char>(name.offset), name.size);
+}
+
+template<typename T>
+void ExpressionStore::checkRange(uint64_t offset, uint64_t count) const
+{
+    if (offset % alignof(T) != 0 ||
+        offset > m_size ||
+        count > (m_size - offset) / sizeof(T))
+    {
+        throw SerializationException("Expression store is damaged");
+    }
+}
+
+void ExpressionStore::validate()
+{
+    checkRange<Header>(0, 1);
+
+    auto& storeHeader = header();
+
+    if (storeHeader.signature != Signature)
+    {
+        throw SerializationException("Data is not an expression store");
+    }
+
+    if (storeHeader.version != Version)
+    {
+        throw SerializationException("Unsupported expression store version");
+    }
+
+    if (storeHeader.byteOrder != ByteOrderMark)
+    {
+        throw SerializationException("Expression store was written with different byte order");
+    }
+
+    if (storeHeader.numberSize != sizeof(Calculator::NumberType))
+    {
+        throw SerializationException("Expression store was written with different number type");
+    }
+
+    checkRange<Expression>(storeHeader.expressionsOffset, storeHeader.expressionsCount);
+    checkRange<Name>(storeHeader.variablesOffset, storeHeader.variablesCount);
+    checkRange<Name>(storeHeader.functionsOffset, storeHeader.functionsCount);
+
+    for (uint32_t i = 0; i < storeHeader.variablesCount; ++i)
+    {
+        checkRange<char>(variable(i).offset, variable(i).size);
+    }
+
+    for (uint32_t i = 0; i < storeHeader.functionsCount; ++i)
+    {
+        checkRange<char>(function(i).offset, function(i).size);
+    }
+
+    // Programs are checked once, so execution
+    // does not check stack bounds.
+    for (uint32_t i = 0; i < storeHeader.expressionsCount; ++i)
+    {
+        auto& stored = expression(i);
+
+        checkRange<Calculator::NumberType>(stored.constantsOffset, stored.constantsCount);
+        checkRange<Instruction>(stored.programOffset, stored.programSize);
+
+        auto program = at<Instruction>(stored.programOffset);
+
+        std::size_t depth = 0;
+
+        for (uint32_t j = 0; j < stored.programSize; ++j)
+        {
+            auto& instruction = program[j];
+
+            switch (static_cast<Calculator::Lexem::Type>(instruction.type))
+            {
+            case Calculator::Lexem::Type::Constant:
+                if (instruction.index >= stored.constantsCount)
+                {
+                    throw SerializationException("Constant index is out of range");
+                }
+
+                ++depth;
+                break;
+
+            case Calculator::Lexem::Type::Variable:
+                if (instruction.index >= storeHeader.variablesCount)
+                {
+                    throw SerializationException("Variable index is out of range");
+                }
+
+                ++depth;
+                break;
+
+            case Calculator::Lexem::Type::Function:
+            {
+                if (instruction.index >= storeHeader.functionsCount)
+                {
+                    throw SerializationException("Function index is out of range");
+                }
+
+                auto numberOfArguments = function(instruction.index).numberOfArguments;
+
+                if (depth < numberOfArguments)
+                {
+                    throw SerializationException("Stored expression is unbalanced");
+                }
+
+                depth = depth - numberOfArguments + 1;
+                break;
+            }
+
+            default:
+                throw SerializationException("Unexpected lexem in expression store");
+            }
+
+            m_stackDepth = std::max(m_stackDepth, depth);
+        }
+
+        if (depth != 1)
+        {
+            throw SerializationException("Stored expression is unbalanced");
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,512 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include "VectorMath.hpp"
+
+namespace
+{
+    // Size of chunk, that's processed at once. Arguments
+    // of chunk are saved, so out of range values can be
+    // recomputed after in place computation.
+    const std::size_t ChunkSize = 256;
+
+    // Adding this value rounds doubles, that are less than 2^51
+    // by absolute value, to integer. Integer is placed in low
+    // bits of mantissa.
+    const double RoundingMagic = 6755399441055744.0; // 1.5 * 2^52
+
+    // Reduction by Pi/2 (fdlibm). First two parts have 33
+    // significant bits, so their products with quadrant
+    // number are exact.
+    const double TwoOverPi = 6.36619772367581382433e-01;
+    const double PiOverTwo1 = 1.57079632673412561417e+00;
+    const double PiOverTwo2 = 6.07710050630396597660e-11;
+    const double PiOverTwo3 = 2.02226624871116645580e-21;
+    const double PiOverTwo2Tail = 6.07710050650619224932e-11;
+    const double TrigonometricLimit = 1e5;
+
+    // Sine and cosine on [-Pi/4, Pi/4] (Cephes)
+    const double S0 =  1.58962301576546568060E-10;
+    const double S1 = -2.50507477628578072866E-8;
+    const double S2 =  2.75573136213857245213E-6;
+    const double S3 = -1.98412698295895385996E-4;
+    const double S4 =  8.33333333332211858878E-3;
+    const double S5 = -1.66666666666666307295E-1;
+
+    const double C0 = -1.13585365213876817300E-11;
+    const double C1 =  2.08757008419747316778E-9;
+    const double C2 = -2.75573141792967388112E-7;
+    const double C3 =  2.48015872888517045348E-5;
+    const double C4 = -1.38888888888730564116E-3;
+    const double C5 =  4.16666666666665929218E-2;
+
+    // Exponent (fdlibm)
+    const double Log2E = 1.44269504088896338700e+00;
+    const double Ln2Hi = 6.93147180369123816490e-01;
+    const double Ln2Lo = 1.90821492927058770002e-10;
+    const double ExpMinimum = -708.0;
+    const double ExpMaximum = 709.0;
+
+    const double P1 =  1.66666666666666019037e-01;
+    const double P2 = -2.77777777770155933842e-03;
+    const double P3 =  6.61375632143793436117e-05;
+    const double P4 = -1.65339022054652515390e-06;
+    const double P5 =  4.13813679705723846039e-08;
+
+    // Logarithm (fdlibm)
+    const double Lg1 = 6.666666666666735130e-01;
+    const double Lg2 = 3.999999999940941908e-01;
+    const double Lg3 = 2.857142874366239149e-01;
+    const double Lg4 = 2.222219843214978396e-01;
+    const double Lg5 = 1.818357216161805012e-01;
+    const double Lg6 = 1.531383769920937332e-01;
+    const double Lg7 = 1.479819860511658591e-01;
+    const double Sqrt2 = 1.41421356237309504880;
+
+    inline int64_t toBits(double value)
+    {
+        int64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    inline double fromBits(int64_t bits)
+    {
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    // 2^exponent for normal range exponents
+    inline double exponent2(int64_t exponent)
+    {
+        return fromBits((exponent + 1023) << 52);
+    }
+
+    /**
+     * @brief Applies vectorizable kernel to values
+     * and recomputes values, that are out of kernel
+     * range, with fallback function.
+     */
+    template<typename Kernel, typename InRange, typename Fallback>
+    void apply(const double* input,
+               double* output,
+               std::size_t count,
+               Kernel kernel,
+               InRange inRange,
+               Fallback fallback)
+    {
+        double saved[ChunkSize];
+
+        for (std::size_t offset = 0; offset < count; offset += ChunkSize)
+        {
+            auto size = std::min(ChunkSize, count - offset);
+            auto chunk = output + offset;
+
+            std::copy(input + offset, input + offset + size, saved);
+
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                chunk[i] = kernel(saved[i]);
+            }
+
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                if (!inRange(saved[i]))
+                {
+                    chunk[i] = fallback(saved[i]);
+                }
+            }
+        }
+    }
+
+    template<typename Function>
+    void applyStandard(const double* input,
+                       double* output,
+                       std::size_t count,
+                       Function function)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            output[i] = function(input[i]);
+        }
+    }
+
+    inline bool trigonometricRange(double value)
+    {
+        return std::abs(value) <= TrigonometricLimit;
+    }
+
+    inline bool exponentRange(double value)
+    {
+        return value >= ExpMinimum && value <= ExpMaximum;
+    }
+
+    inline bool logarithmRange(double value)
+    {
+        return value >= std::numeric_limits<double>::min() &&
+               value <= std::numeric_limits<double>::max();
+    }
+
+    /**
+     * @brief Computes sine or cosine of reduced
+     * argument depending on quadrant.
+     */
+    template<bool Cosine, bool Precise>
+    inline double trigonometric(double value)
+    {
+        auto rounded = value * TwoOverPi + RoundingMagic;
+        auto quadrant = toBits(rounded) + (Cosine ? 1 : 0);
+        auto q = rounded - RoundingMagic;
+
+        double r;
+
+        if constexpr (Precise)
+        {
+            r = ((value - q * PiOverTwo1) - q * PiOverTwo2) - q * PiOverTwo3;
+        }
+        else
+        {
+            r = (value - q * PiOverTwo1) - q * PiOverTwo2Tail;
+        }
+
+        auto z = r * r;
+
+        double sine;
+        double cosine;
+
+        if constexpr (Precise)
+        {
+            sine = r + r * z * (S5 + z * (S4 + z * (S3 + z * (S2 + z * (S1 + z * S0)))));
+
+            auto halfZ = 0.5 * z;
+            auto w = 1.0 - halfZ;
+
+            cosine = w + (((1.0 - w) - halfZ) +
+                          z * z * (C5 + z * (C4 + z * (C3 + z * (C2 + z * (C1 + z * C0))))));
+        }
+        else
+        {
+            sine = r + r * z * (-1.0 / 6 + z * (1.0 / 120 + z * (-1.0 / 5040 + z * (1.0 / 362880))));
+            cosine = 1.0 - 0.5 * z + z * z * (1.0 / 24 + z * (-1.0 / 720 + z * (1.0 / 40320 + z * (-1.0 / 3628800))));
+        }
+
+        auto result = (quadrant & 1) ? cosine : sine;
+
+        return (quadrant & 2) ? -result : result;
+    }
+
+    template<bool Precise>
+    inline double exponent(double value)
+    {
+        auto rounded = value * Log2E + RoundingMagic;
+        auto k = toBits(rounded) - toBits(RoundingMagic);
+        auto dk = rounded - RoundingMagic;
+
+        double result;
+
+        if constexpr (Precise)
+        {
+            auto hi = value - dk * Ln2Hi;
+            auto lo = dk * Ln2Lo;
+            auto r = hi - lo;
+            auto t = r * r;
+            auto c = r - t * (P1 + t * (P2 + t * (P3 + t * (P4 + t * P5))));
+
+            result = 1.0 - ((lo - (r * c) / (2.0 - c)) - hi);
+        }
+        else
+        {
+            auto r = (value - dk * Ln2Hi) - dk * Ln2Lo;
+
+            result = 1.0 + r * (1.0 + r * (1.0 / 2 + r * (1.0 / 6 + r * (1.0 / 24 +
+                     r * (1.0 / 120 + r * (1.0 / 720 + r * (1.0 / 5040)))))));
+        }
+
+        return result * exponent2(k);
+    }
+
+    template<bool Precise>
+    inline double logarithm(double value)
+    {
+        auto bits = toBits(value);
+
+        // Splitting on exponent and mantissa in [1, 2)
+        auto k = (bits >> 52) - 1023;
+        auto m = fromBits((bits & 0x000FFFFFFFFFFFFFLL) | 0x3FF0000000000000LL);
+
+        // Moving mantissa to [sqrt(2) / 2, sqrt(2))
+        auto big = m > Sqrt2;
+        m = big ? m * 0.5 : m;
+
+        auto dk = static_cast<double>(k) + (big ? 1.0 : 0.0);
+
+        auto f = m - 1.0;
+        auto s = f / (2.0 + f);
+        auto z = s * s;
+
+        if constexpr (Precise)
+        {
+            auto w = z * z;
+            auto t1 = w * (Lg2 + w * (Lg4 + w * Lg6));
+            auto t2 = z * (Lg1 + w * (Lg3 + w * (Lg5 + w * Lg7)));
+            auto r = t2 + t1;
+            auto halfSquare = 0.5 * f * f;
+
+            return dk * Ln2Hi - ((halfSquare - (s * (halfSquare + r) + dk * Ln2Lo)) - f);
+        }
+        else
+        {
+            // log(m) = 2 * atanh(s)
+            auto series = s * (2.0 + z * (2.0 / 3 + z * (2.0 / 5 + z * (2.0 / 7 + z * (2.0 / 9)))));
+
+            return dk * (Ln2Hi + Ln2Lo) + series;
+        }
+    }
+}
+
+void VectorMath::sin(const double* input, double* output, std::size_t count, MathAccuracy accuracy)
+{
+    auto fallback = [](double value) { return std::sin(value); };
+
+    switch (accuracy)
+    {
+    case MathAccuracy::CorrectlyRounded:
+        applyStandard(input, output, count, fallback);
+        break;
+    case MathAccuracy::Ulp1:
+        apply(input, output, count, trigonometric<false, true>, trigonometricRange, fallback);
+        break;
+    case MathAccuracy::Fast:
+        apply(input, output, count, trigonometric<false, false>, trigonometricRange, fallback);
+        break;
+    }
+}
+
+void VectorMath::cos(const double* input, double* output, std::size_t count, MathAccuracy accuracy)
+{
+    auto fallback = [](double value) { return std::cos(value); };
+
+    switch (accuracy)
+    {
+    case MathAccuracy::CorrectlyRounded:
+        applyStandard(input, output, count, fallback);
+        break;
+    case MathAccuracy::Ulp1:
+        apply(input, output, count, trigonometric<true, true>, trigonometricRange, fallback);
+        break;
+    case MathAccuracy::Fast:
+        apply(input, output, count, trigonometric<true, false>, trigonometricRange, fallback);
+        break;
+    }
+}
+
+void VectorMath::exp(const double* input, double* output, std::size_t count, MathAccuracy accuracy)
+{
+    auto fallback = [](double value) { return std::exp(value); };
+
+    switch (accuracy)
+    {
+    case MathAccuracy::CorrectlyRounded:
+        applyStandard(input, output, count, fallback);
+        break;
+    case MathAccuracy::Ulp1:
+        apply(input, output, count, exponent<true>, exponentRange, fallback);
+        break;
+    case MathAccuracy::Fast:
+        apply(input, output, count, exponent<false>, exponentRange, fallback);
+        break;
+    }
+}
+
+void VectorMath::log(const double* input, double* output, std::size_t count, MathAccuracy accuracy)
+{
+    auto fallback = [](double value) { return std::log(value); };
+
+    switch (accuracy)
+    {
+    case MathAccuracy::CorrectlyRounded:
+        applyStandard(input, output, count, fallback);
+        break;
+    case MathAccuracy::Ulp1:
+        apply(input, output, count, logarithm<true>, logarithmRange, fallback);
+        break;
+    case MathAccuracy::Fast:
+        apply(input, output, count, logarithm<false>, logarithmRange, fallback);
+        break;
+    }
+}
+
+void VectorMath::sqrt(const double* input, double* output, std::size_t count, MathAccuracy /* accuracy */)
+{
+    // Square root instruction is correctly rounded
+    applyStandard(
+        input,
+        output,
+        count,
+        [](double value) { return std::sqrt(value); }
+    );
+}
+
+void VectorMath::pow(const double* base,
+                     const double* exponent,
+                     double* output,
+                     std::size_t count,
+                     MathAccuracy accuracy)
+{
+    if (accuracy != MathAccuracy::Fast)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            output[i] = std::pow(base[i], exponent[i]);
+        }
+
+        return;
+    }
+
+    double savedBase[ChunkSize];
+    double savedExponent[ChunkSize];
+    double products[ChunkSize];
+
+    for (std::size_t offset = 0; offset < count; offset += ChunkSize)
+    {
+        auto size = std::min(ChunkSize, count - offset);
+        auto chunk = output + offset;
+
+        std::copy(base + offset, base + offset + size, savedBase);
+        std::copy(exponent + offset, exponent + offset + size, savedExponent);
+
+        // Precise logarithm keeps error of product
+        // small for big exponents.
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            products[i] = savedExponent[i] * logarithm<true>(savedBase[i]);
+        }
+
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            chunk[i] = ::exponent<false>(products[i]);
+        }
+
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            if (!logarithmRange(savedBase[i]) ||
+                !exponentRange(products[i]))
+            {
+                chunk[i] = std::pow(savedBase[i], savedExponent[i]);
+            }
+        }
+    }
+}
+
+namespace
+{
+    // Number of independent accumulators. Reductions
+    // don't wait for previous addition, so they
+    // are vectorized by compiler.
+    const std::size_t Accumulators = 8;
+
+    template<typename Combine>
+    double accumulate(const double* input, std::size_t count, double initial, Combine combine)
+    {
+        double accumulators[Accumulators];
+
+        std::fill(accumulators, accumulators + Accumulators, initial);
+
+        std::size_t i = 0;
+
+        for (; i + Accumulators <= count; i += Accumulators)
+        {
+            for (std::size_t j = 0; j < Accumulators; ++j)
+            {
+                accumulators[j] = combine(accumulators[j], input[i + j]);
+            }
+        }
+
+        for (; i < count; ++i)
+        {
+            accumulators[0] = combine(accumulators[0], input[i]);
+        }
+
+        auto result = initial;
+
+        for (auto accumulator : accumulators)
+        {
+            result = combine(result, accumulator);
+        }
+
+        return result;
+    }
+}
+
+double VectorMath::sum(const double* input, std::size_t count)
+{
+    return accumulate(
+        input,
+        count,
+        0.0,
+        [](double accumulator, double value)
+        {
+            return accumulator + value;
+        }
+    );
+}
+
+double VectorMath::min(const double* input, std::size_t count)
+{
+    return accumulate(
+        input,
+        count,
+        std::numeric_limits<double>::infinity(),
+        [](double accumulator, double value)
+        {
+            // NaN value doesn't pass comparison
+            return value < accumulator ? value : accumulator;
+        }
+    );
+}
+
+double VectorMath::max(const double* input, std::size_t count)
+{
+    return accumulate(
+        input,
+        count,
+        -std::numeric_limits<double>::infinity(),
+        [](double accumulator, double value)
+        {
+            // NaN value doesn't pass comparison
+            return value > accumulator ? value : accumulator;
+        }
+    );
+}
+
+double VectorMath::dot(const double* lhs, const double* rhs, std::size_t count)
+{
+    double accumulators[Accumulators] = {};
+
+    std::size_t i = 0;
+
+    for (; i + Accumulators <= count; i += Accumulators)
+    {
+        for (std::size_t j = 0; j < Accumulators; ++j)
+        {
+            accumulators[j] += lhs[i + j] * rhs[i + j];
+        }
+    }
+
+    for (; i < count; ++i)
+    {
+        accumulators[0] += lhs[i] * rhs[i];
+    }
+
+    double result = 0;
+
+    for (auto accumulator : accumulators)
+    {
+        result += accumulator;
+    }
+
+    return result;
+}
\ No newline at end of file
@@ -3,6 +3,45 @@
 #include <cmath>
 #include <StatementException.hpp>
 #include <ParsingException.hpp>
+#include <SerializationException.hpp>
+#include <SymbolTable.hpp>
+#include <CompileTrace.hpp>
+#include <VectorMath.hpp>
+#include <sstream>
+#include <fstream>
+#include <memory_resource>
+#include <map>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    // Number of heap allocations of the process.
+    std::atomic<std::size_t> allocationsCount(0);
+}
+
+void* operator new(std::size_t size)
+{
+    ++allocationsCount;
+
+    if (auto pointer = std::malloc(size ? size : 1))
+    {
+        return pointer;
+    }
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t /* size */) noexcept
+{
+    std::free(pointer);
+}
 
 TEST(Parsing, MinusAfter)
 {
@@ -68,6 +107,21 @@ TEST(Basic, Factorial)
 
     ASSERT_NO_THROW(calc.setExpression("5.2!"));
     ASSERT_DOUBLE_EQ(calc.execute(), 169.406099461722999);
+
+    // Operator is expected after postfix one
+    ASSERT_NO_THROW(calc.setExpression("5! + 1"));
+    ASSERT_DOUBLE_EQ(calc.execute(), 121);
+
+    ASSERT_NO_THROW(calc.setExpression("3! * 2"));
+    ASSERT_DOUBLE_EQ(calc.execute(), 12);
+
+    calc.setVariable("x", 2);
+
+    ASSERT_NO_THROW(calc.setExpression("x! + 1"));
+    ASSERT_DOUBLE_EQ(calc.execute(), 3);
+
+    ASSERT_NO_THROW(calc.setExpression("2 * (2 + 1)! - 1"));
+    ASSERT_DOUBLE_EQ(calc.execute(), 11);
 }
 
 TEST(Errors, UnbalancedBraces1)
@@ -114,6 +168,24 @@ TEST(Errors, UnbalancedStatement)
     );
 }
 
+TEST(Errors, EmptyExpression)
+{
+    Calculator calc;
+    calc.addBasicFunctions();
+
+    ASSERT_THROW(calc.execute(), StatementException);
+
+    // Failed compilation leaves no program
+    ASSERT_NO_THROW(calc.setExpression("1 + 2 * 3 - 4"));
+    ASSERT_DOUBLE_EQ(calc.execute(), 3);
+
+    ASSERT_ANY_THROW(calc.setExpression("(1 + 2"));
+    ASSERT_THROW(calc.execute(), StatementException);
+
+    calc.setBackend(Calculator::Backend::Register);
+    ASSERT_THROW(calc.execute(), StatementException);
+}
+
 TEST(Errors, WrongArgumentsNumber)
 {
     Calculator calc;
@@ -166,6 +238,117 @@ TEST(Variables, Basic)
     }
 }
 
+TEST(Variables, Provider)
+{
+    Calculator calc;
+    calc.addBasicFunctions();
+    calc.addArrayFunctions();
+
+    calc.setArray("weights", {1, 2});
+    calc.setVariable("b", 10);
+
+    ASSERT_NO_THROW(calc.setExpression("c * b + a + sum(weights * a)"));
+
+    // Reductions are computed first
+    ASSERT_EQ(calc.referencedVariables(), (std::vector<std::string_view>{"weights", "a", "c", "b"}));
+
+    // Values and requests log
+    using Store = std::pair<std::map<std::string_view, double>, std::vector<std::string>>;
+
+    Store store;
+    store.first = {{"a", 2}, {"c", 3}, {"unused", 100}};
+
+    calc.setVariableProvider(
+        [](Calculator::VariableRequest* requests, std::size_t count, void* context)
+        {
+            auto& data = *static_cast<Store*>(context);
+
+            data.second.emplace_back();
+
+            for (auto request = requests; request != requests + count; ++request)
+            {
+                data.second.back().append(request->name).append(" ");
+
+                auto search = data.first.find(request->name);
+
+                if (search != data.first.end())
+                {
+                    request->value = search->second;
+                    request->found = true;
+                }
+            }
+        },
+        &store
+    );
+
+    ASSERT_DOUBLE_EQ(calc.execute(), 3 * 10 + 2 + (1 + 2) * 2);
+    ASSERT_EQ(store.second, (std::vector<std::string>{"a c "}));
+
+    // Values are requested on every execution
+    store.first["a"] = 1;
+
+    ASSERT_DOUBLE_EQ(calc.execute(), 3 * 10 + 1 + (1 + 2) * 1);
+    ASSERT_EQ(store.second.size(), 2u);
+
+    store.first.erase("c");
+
+    ASSERT_THROW(calc.execute(), CalculationException);
+
+    // Own values are not requested
+    calc.setVariable("c", 1);
+
+    ASSERT_DOUBLE_EQ(calc.execute(), 10 + 1 + 3);
+    ASSERT_EQ(store.second.back(), "a ");
+
+    // Columns are not requested
+    ASSERT_NO_THROW(calc.setExpression("c * b + a"));
+
+    std::vector<double> a = {1, 2};
+    std::vector<double> results(2);
+
+    calc.executeBatch({{"a", a.data()}}, a.size(), results.data());
+
+    ASSERT_EQ(store.second.size(), 4u);
+    ASSERT_DOUBLE_EQ(results[1], 10 + 2);
+
+    // Provider is used by every execution path
+    calc.deleteVariable("c");
+    store.first["c"] = 3;
+
+    calc.setProfiling(true);
+    ASSERT_DOUBLE_EQ(calc.execute(), 3 * 10 + 1);
+    calc.setProfiling(false);
+
+    std::vector<double> b = {1, 2};
+
+    calc.sweep({{"b", b.data(), b.size()}}, results.data());
+    ASSERT_DOUBLE_EQ(results[1], 3 * 2 + 1);
+
+    Calculator::SolverOptions options;
+    options.lower = -10;
+    options.upper = 10;
+
+    calc.solveBatch("b", {}, 1, nullptr, options, results.data(), nullptr, nullptr);
+    ASSERT_NEAR(results[0], -1.0 / 3, 1e-9);
+
+    std::stringstream stream;
+    calc.saveStore(stream, {"c * 2 + a"});
+
+    auto data = stream.str();
+    std::vector<uint64_t> buffer((data.size() + 7) / 8);
+    std::copy(data.begin(), data.end(), reinterpret_cast<char*>(buffer.data()));
+
+    ExpressionStore expressionStore(buffer.data(), data.size());
+
+    ASSERT_NO_THROW(calc.bindStore(expressionStore));
+    ASSERT_DOUBLE_EQ(calc.executeStored(0), 3 * 2 + 1);
+    ASSERT_EQ(store.second.back(), "c a ");
+
+    calc.setVariableProvider(nullptr, nullptr);
+
+    ASSERT_THROW(calc.execute(), CalculationException);
+}
+
 TEST(Logic, Comparison)
 {
     Calculator calc;
@@ -239,6 +422,1508 @@ TEST(Constants, Base)
     ASSERT_DOUBLE_EQ(calc.execute(), M_E);
 }
 
+TEST(Serialization, RoundTrip)
+{
+    Calculator source;
+    source.addBasicFunctions();
+
+    ASSERT_NO_THROW(source.setExpression("12 / 22 / x * sin(y) + 2 * 3"));
+
+    source.setVariable("x", 0.2);
+    source.setVariable("y", 3.14 / 2);
+
+    std::stringstream stream;
+    ASSERT_NO_THROW(source.saveExpression(stream));
+
+    Calculator calc;
+    calc.addBasicFunctions();
+
+    ASSERT_NO_THROW(calc.loadExpression(stream));
+
+    calc.setVariable("x", 0.2);
+    calc.setVariable("y", 3.14 / 2);
+
+    ASSERT_EQ(calc.execute(), source.execute());
+}
+
+TEST(Serialization, UnknownFunction)
+{
+    Calculator source;
+    source.addBasicFunctions();
+
+    ASSERT_NO_THROW(source.setExpression("sin(x)"));
+
+    std::stringstream stream;
+    ASSERT_NO_THROW(source.saveExpression(stream));
+
+    Calculator calc;
+
+    ASSERT_THROW(
+        calc.loadExpression(stream),
+        SerializationException
+    );
+}
+
+TEST(Serialization, DamagedData)
+{
+    Calculator source;
+
+    ASSERT_NO_THROW(source.setExpression("x + 1"));
+
+    std::stringstream stream;
+    ASSERT_NO_THROW(source.saveExpression(stream));
+
+    auto data = stream.str();
+
+    Calculator calc;
+
+    // Wrong format version
+    auto version = data;
+    version[4] = 0x7F;
+
+    std::stringstream versionStream(version);
+    ASSERT_THROW(
+        calc.loadExpression(versionStream),
+        SerializationException
+    );
+
+    // Truncated data
+    std::stringstream truncatedStream(data.substr(0, data.size() - 2));
+    ASSERT_THROW(
+        calc.loadExpression(truncatedStream),
+        SerializationException
+    );
+
+    // Damaged sizes of constant pool and variable name
+    // are not allocated at once. Header has 13 bytes,
+    // pool has one constant.
+    for (std::size_t offset : {13, 29})
+    {
+        auto damaged = data;
+        std::fill_n(damaged.begin() + static_cast<std::ptrdiff_t>(offset), 4, '\xFF');
+
+        std::stringstream damagedStream(damaged);
+        ASSERT_THROW(
+            calc.loadExpression(damagedStream),
+            SerializationException
+        );
+    }
+
+    // Signed zeros are different constants
+    ASSERT_NO_THROW(source.setExpression("(x - 0.0) / -0.0"));
+
+    std::stringstream zeroStream;
+    ASSERT_NO_THROW(source.saveExpression(zeroStream));
+    ASSERT_NO_THROW(calc.loadExpression(zeroStream));
+
+    calc.setVariable("x", 1);
+    ASSERT_EQ(calc.execute(), -std::numeric_limits<double>::infinity());
+
+    // Arrays of reductions are not saved
+    source.addArrayFunctions();
+    source.setArray("a", {1, 2});
+
+    ASSERT_NO_THROW(source.setExpression("sum(a) + 1"));
+
+    std::stringstream reductionStream;
+    ASSERT_THROW(source.saveExpression(reductionStream), SerializationException);
+}
+
+TEST(Registry, SymbolTable)
+{
+    SymbolTable<int> table;
+
+    for (int i = 0; i < 5000; ++i)
+    {
+        ASSERT_EQ(table.insert("name_" + std::to_string(i), i), static_cast<std::size_t>(i));
+    }
+
+    for (int frozen = 0; frozen < 2; ++frozen)
+    {
+        for (int i = 0; i < 5000; ++i)
+        {
+            auto name = "name_" + std::to_string(i);
+            auto index = table.find(name);
+
+            ASSERT_NE(index, table.npos);
+            ASSERT_EQ(table[index], i);
+            ASSERT_EQ(table.name(index), name);
+        }
+
+        ASSERT_EQ(table.find("name_5000"), table.npos);
+        ASSERT_EQ(table.find("name"), table.npos);
+        ASSERT_EQ(table.find(""), table.npos);
+
+        table.freeze();
+        ASSERT_TRUE(table.isFrozen());
+    }
+
+    // Replacing value keeps table frozen
+    table.insert("name_10", 11);
+    ASSERT_TRUE(table.isFrozen());
+    ASSERT_EQ(table[table.find("name_10")], 11);
+
+    // New name unfreezes it
+    table.insert("other", 1);
+    ASSERT_FALSE(table.isFrozen());
+    ASSERT_EQ(table[table.find("other")], 1);
+    ASSERT_EQ(table[table.find("name_4999")], 4999);
+}
+
+TEST(Registry, Frozen)
+{
+    Calculator calc;
+    calc.addBasicFunctions();
+    calc.addConstants();
+    calc.setVariable("x", 2);
+
+    calc.freezeRegistry();
+
+    ASSERT_NO_THROW(calc.setExpression("sin(Pi / 2) * x + y"));
+
+    calc.setVariable("y", 1);
+    ASSERT_DOUBLE_EQ(calc.execute(), 3);
+
+    calc.deleteVariable("y");
+    ASSERT_THROW(calc.execute(), CalculationException);
+    ASSERT_THROW(calc.deleteVariable("y"), std::invalid_argument);
+}
+
+TEST(Allocation, CompileArena)
+{
+    struct CountingResource : std::pmr::memory_resource
+    {
+        std::size_t allocations = 0;
+
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override
+        {
+            ++allocations;
+            return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        }
+
+        void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override
+        {
+            std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+        {
+            return this == &other;
+        }
+    } resource;
+
+    Calculator calc;
+    calc.addBasicFunctions();
+    calc.setMemoryResource(&resource);
+
+    std::string expression = "(1 + 2) * x + (x ^ 2 + 3 * x + 1) / 2";
+
+    for (int i = 0; i < 200; ++i)
+    {
+        expression += " + sin(x) * " + std::to_string(i);
+    }
+
+    // Warm up
+    ASSERT_NO_THROW(calc.setExpression(expression));
+    ASSERT_NO_THROW(calc.setExpression(expression));
+
+    auto allocations = resource.allocations;
+
+    ASSERT_GT(allocations, 0);
+
+    for (int i = 0; i < 10; ++i)
+    {
+        ASSERT_NO_THROW(calc.setExpression(expression));
+    }
+
+    ASSERT_EQ(resource.allocations, allocations);
+
+    // Compilation does not use global heap
+    auto globalAllocations = allocationsCount.load();
+
+    for (int i = 0; i < 10; ++i)
+    {
+        ASSERT_NO_THROW(calc.setExpression(expression));
+    }
+
+    ASSERT_EQ(allocationsCount.load(), globalAllocations);
+
+    calc.setVariable("x", 1);
+
+    Calculator reference;
+    reference.addBasicFunctions();
+    reference.setVariable("x", 1);
+
+    ASSERT_NO_THROW(reference.setExpression(expression));
+    ASSERT_DOUBLE_EQ(calc.execute(), reference.execute());
+}
+
+TEST(Allocation, SteadyState)
+{
+    Calculator calc;
+    calc.addBasicFunctions();
+    calc.addLogicFunctions();
+    calc.addArrayFunctions();
+    calc.addStreamFunctions();
+
+    calc.setArray("weights", {1, 2, 3});
+
+    auto x = calc.variableHandle("x");
+
+    calc.setVariable(x, 1);
+    calc.setVariable("y", 2);
+
+    for (auto backend : {Calculator::Backend::Stack, Calculator::Backend::Register})
+    {
+        calc.setBackend(backend);
+
+        ASSERT_NO_THROW(calc.setExpression(
+            "sin(x) * y + if (x > y) {x} {y} + sum(weights * x) + ema(x, 0.5) + x^3 - 2 * x"
+        ));
+
+        // Warm up
+        ASSERT_NO_THROW(calc.execute());
+        ASSERT_EQ(calc.tryExecute().status, Calculator::ExecutionStatus::Success);
+
+        auto allocations = allocationsCount.load();
+
+        double sum = 0;
+
+        for (int i = 0; i < 100; ++i)
+        {
+            calc.setVariable(x, i);
+            calc.setVariable("y", i / 2.0);
+
+            sum += calc.execute();
+            sum += calc.tryExecute().value;
+        }
+
+        ASSERT_EQ(allocationsCount.load(), allocations);
+        ASSERT_TRUE(std::isfinite(sum));
+    }
+
+    // Handle and name refer to the same variable
+    ASSERT_NO_THROW(calc.setExpression("x"));
+
+    calc.setVariable(x, 5);
+    ASSERT_DOUBLE_EQ(calc.execute(), 5);
+
+    calc.setVariable("x", 6);
+    ASSERT_DOUBLE_EQ(calc.execute(), 6);
+}
+
+TEST(Statistics, PhaseTimes)
+{
+    Calculator calc;
+    calc.addBasicFunctions();
+
+    Calculator::CompileStatistics statistics;
+
+    ASSERT_NO_THROW(calc.setExpression("sin(x) * 2 + 1", false, &statistics));
+    ASSERT_GT(statistics.splittingTime.count(), 0);
+    ASSERT_GT(statistics.pushingTime.count(), 0);
+    ASSERT_EQ(statistics.optimizationTime.count(), 0);
+
+    ASSERT_NO_THROW(calc.setExpression("sin(x) * 2 + 1", true, &statistics));
+    ASSERT_GT(statistics.optimizationTime.count(), 0);
+}
+
+TEST(Profiling, Counts)
+{
+    Calculator calc;
+    calc.addBasicFunctions();
+
+    ASSERT_NO_THROW(calc.setExpression("sin(x) * 2 + cos(x)"));
+    calc.setVariable("x", 1);
+
+    // Disabled profiling collects nothing
+    calc.execute();
+    ASSERT_EQ(calc.getProfile().executions, 0);
+    ASSERT_TRUE(calc.getProfile().positions.empty());
+
+    calc.setProfiling(true);
+
+    for (int i = 0; i < 10; ++i)
+    {
+        ASSERT_DOUBLE_EQ(calc.execute(), std::sin(1) * 2 + std::cos(1));
+    }
+
+    auto profile = calc.getProfile();
+
+    ASSERT_EQ(profile.executions, 10);
+
+    Calculator::LexemStack rpn;
+    calc.getRPN(rpn);
+
+    ASSERT_EQ(profile.positions.size(), rpn.size());
+
+    for (auto&& entry : profile.positions)
+    {
+        ASSERT_EQ(entry.calls, 10);
+    }
+
+    ASSERT_EQ(profile.functions.size(), 4);
+    ASSERT_EQ(profile.functions["sin"].calls, 10);
+    ASSERT_EQ(profile.functions["+"].calls, 10);
+
+    std::stringstream report;
+    calc.printProfile(report);
+    ASSERT_NE(report.str().find("sin()"), std::string::npos);
+
+    // Changing expression resets profile
+    ASSERT_NO_THROW(calc.setExpression("x + 1"));
+    ASSERT_EQ(calc.getProfile().executions, 0);
+    ASSERT_EQ(calc.getProfile().positions.size(), 3);
+}
+
+TEST(Statistics, Counters)
+{
+    Calculator calc;
+    calc.addBasicFunctions();
+
+    Calculator::CompileStatistics statistics;
+
+    // Lexems: ( 1 + 2 ) * x + sin ( 0 )
+    ASSERT_NO_THROW(calc.setExpression("(1 + 2) * x + sin(0)", true, &statistics));
+
+    ASSERT_EQ(statistics.lexemsCount, 12);
+    ASSERT_EQ(statistics.rpnLength, 8);
+    ASSERT_EQ(statistics.foldsCount, 2);
+    ASSERT_EQ(statistics.optimizedLength, 5);
+    ASSERT_EQ(statistics.maxStackDepth, 2);
+
+    CompileTrace trace;
+    trace.addCompilation("tenant \"A\"", statistics);
+    trace.addCompilation("tenant B", statistics, 1);
+
+    std::stringstream stream;
+    trace.write(stream);
+
+    auto json = stream.str();
+
+    ASSERT_EQ(json.find("{\"traceEvents\":["), 0);
+    ASSERT_NE(json.find("\"name\":\"tenant \\\"A\\\"\""), std::string::npos);
+    ASSERT_NE(json.find("\"name\":\"performOptimization\""), std::string::npos);
+    ASSERT_NE(json.find("\"folds\":2"), std::string::npos);
+}
+
+TEST(Math, AccuracyTiers)
+{
+    std::vector<double> trigonometric;
+    std::vector<double> positive;
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        trigonometric.push_back(-100.0 + i * 0.2003);
+        positive.push_back(1e-5 + i * 0.7013);
+    }
+
+    std::vector<double> result(trigonometric.size());
+
+    using Kernel = void (*)(const double*, double*, std::size_t, MathAccuracy);
+
+    auto check = [&result](Kernel kernel,
+                           double (*reference)(double),
+                           const std::vector<double>& input,
+                           MathAccuracy accuracy,
+                           double tolerance)
+    {
+        kernel(input.data(), result.data(), input.size(), accuracy);
+
+        for (std::size_t i = 0; i < input.size(); ++i)
+        {
+            auto expected = reference(input[i]);
+
+            ASSERT_NEAR(result[i], expected, std::abs(expected) * tolerance + 1e-300)
+                << "argument " << input[i];
+        }
+    };
+
+    for (auto accuracy : {MathAccuracy::CorrectlyRounded, MathAccuracy::Ulp1})
+    {
+        auto tolerance = accuracy == MathAccuracy::CorrectlyRounded ? 0 : 4e-16;
+
+        check(VectorMath::exp, std::exp, trigonometric, accuracy, tolerance);
+        check(VectorMath::log, std::log, positive, accuracy, tolerance);
+        check(VectorMath::sqrt, std::sqrt, positive, accuracy, 0);
+    }
+
+    // Absolute error near zeros of sine and cosine
+    for (auto accuracy : {MathAccuracy::Ulp1, MathAccuracy::Fast})
+    {
+        auto tolerance = accuracy == MathAccuracy::Ulp1 ? 1e-15 : 1e-8;
+
+        VectorMath::sin(trigonometric.data(), result.data(), trigonometric.size(), accuracy);
+
+        for (std::size_t i = 0; i < trigonometric.size(); ++i)
+        {
+            ASSERT_NEAR(result[i], std::sin(trigonometric[i]), tolerance);
+        }
+
+        VectorMath::cos(trigonometric.data(), result.data(), trigonometric.size(), accuracy);
+
+        for (std::size_t i = 0; i < trigonometric.size(); ++i)
+        {
+            ASSERT_NEAR(result[i], std::cos(trigonometric[i]), tolerance);
+        }
+    }
+
+    check(VectorMath::exp, std::exp, trigonometric, MathAccuracy::Fast, 1e-7);
+    check(VectorMath::log, std::log, positive, MathAccuracy::Fast, 1e-7);
+
+    // Out of range arguments and in place computation
+    std::vector<double> special = {1e300, -1e300, 0, -1, 1e6, 800, -800};
+
+    VectorMath::exp(special.data(), special.data(), special.size(), MathAccuracy::Fast);
+
+    ASSERT_EQ(special[0], INFINITY);
+    ASSERT_EQ(special[1], 0);
+    ASSERT_EQ(special[2], 1);
+    ASSERT_EQ(special[5], INFINITY);
+
+    special = {0, -1, INFINITY};
+
+    VectorMath::log(special.data(), special.data(), special.size(), MathAccuracy::Ulp1);
+
+    ASSERT_EQ(special[0], -INFINITY);
+    ASSERT_TRUE(std::isnan(special[1]));
+    ASSERT_EQ(special[2], INFINITY);
+}
+
+TEST(Batch, Execute)
+{
+    Calculator calc;
+    calc.addBasicFunctions();
+    calc.addLogicFunctions();
+
+    ASSERT_NO_THROW(calc.setExpression("sin(x) * exp(y / 10) + atan2(x, y) + if(x > y, k, 2) ^ 2"));
+
+    std::vector<double> x;
+    std::vector<double> y;
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        x.push_back(i * 0.01 - 3);
+        y.push_back(5 - i * 0.003);
+    }
+
+    std::vector<double> results(x.size());
+
+    // Variable without column
+    ASSERT_THROW(calc.executeBatch({{"x", x.data()}, {"y", y.data()}}, x.size(), results.data()), CalculationException);
+
+    calc.setVariable("k", 3);
+
+    for (auto accuracy : {MathAccuracy::CorrectlyRounded, MathAccuracy::Ulp1, MathAccuracy::Fast})
+    {
+        calc.setMathAccuracy(accuracy);
+
+        ASSERT_NO_THROW(calc.executeBatch({{"x", x.data()}, {"y", y.data()}}, x.size(), results.data()));
+
+        for (std::size_t i = 0; i < x.size(); ++i)
+        {
+            calc.setVariable("x", x[i]);
+            calc.setVariable("y", y[i]);
+
+            auto expected = calc.execute();
+
+            if (accuracy == MathAccuracy::CorrectlyRounded)
+            {
+                ASSERT_DOUBLE_EQ(results[i], expected);
+            }
+            else
+            {
+                ASSERT_NEAR(results[i], expected, 1e-6);
+            }
+        }
+    }
+}
+
+TEST(Batch, Sweep)
+{
+    Calculator calc;
+    calc.addBasicFunctions();
+
+    std::vector<double> r = {0.01, 0.02, 0.05};
+    std::vector<double> s = {80, 90, 100, 110};
+    std::vector<double> t(300);
+
+    for (std::size_t i = 0; i < t.size(); ++i)
+    {
+        t[i] = 0.01 * static_cast<double>(i);
+    }
+
+    calc.setVariable("p", 3);
+
+    ASSERT_NO_THROW(calc.setExpression("exp(0 - r * t) * log(s) + sqrt(s + p) * t + (r + 1) * (s - p)"));
+
+    std::vector<double> results(r.size() * s.size() * t.size());
+
+    calc.sweep({{"r", r.data(), r.size()}, {"s", s.data(), s.size()}, {"t", t.data(), t.size()}}, results.data());
+
+    auto result = results.begin();
+
+    for (auto rValue : r)
+    {
+        for (auto sValue : s)
+        {
+            for (auto tValue : t)
+            {
+                calc.setVariable("r", rValue);
+                calc.setVariable("s", sValue);
+                calc.setVariable("t", tValue);
+
+                ASSERT_NEAR(*result++, calc.execute(), 1e-9);
+            }
+        }
+    }
+
+    // Expression doesn't depend on inner axis
+    ASSERT_NO_THROW(calc.setExpression("r * 2 + p"));
+
+    results.assign(r.size() * 2, 0);
+
+    calc.sweep({{"r", r.data(), r.size()}, {"unused", t.data(), 2}}, results.data());
+
+    ASSERT_DOUBLE_EQ(results[0], 3.02);
+    ASSERT_DOUBLE_EQ(results[1], 3.02);
+    ASSERT_DOUBLE_EQ(results[5], 3.1);
+
+    ASSERT_THROW(
+        calc.sweep({{"r", r.data(), r.size()}, {"r", r.data(), r.size()}}, results.data()),
+        std::invalid_argument
+    );
+
+    // Reductions are computed before sweep
+    calc.addArrayFunctions();
+    calc.setArray("a", {1, 2, 3});
+
+    ASSERT_NO_THROW(calc.setExpression("sum(a * p) + r"));
+
+    calc.sweep({{"r", r.data(), r.size()}}, results.data());
+    ASSERT_DOUBLE_EQ(results[2], 18.05);
+
+    ASSERT_NO_THROW(calc.setExpression("sum(a * r)"));
+
+    ASSERT_THROW(calc.sweep({{"r", r.data(), r.size()}}, results.data()), std::invalid_argument);
+}
+
+TEST(Program, Fusion)
+{
+    Calculator calc;
+    calc.addBasicFunctions();
+    calc.setVariable("x", 3);
+    calc.setVariable("y", 7);
+
+    Calculator::CompileStatistics statistics;
+
+    // RPN: x 2 / y x * + sin 1 +
+    ASSERT_NO_THROW(calc.setExpression("sin(x / 2 + y * x) + 1", true, &statistics));
+
+    ASSERT_EQ(statistics.optimizedLength, 10);
+    ASSERT_EQ(statistics.instructionsCount, 5);
+
+    calc.setProfiling(true);
+    auto expected = calc.execute();
+    calc.setProfiling(false);
+
+    ASSERT_DOUBLE_EQ(calc.execute(), expected);
+
+    // Variables are read in place
+    calc.setVariable("x", 5);
+    calc.setProfiling(true);
+    expected = calc.execute();
+    calc.setProfiling(false);
+
+    ASSERT_DOUBLE_EQ(calc.execute(), expected);
+
+    // Replaced operator is not inlined
+    calc.addFunction(
+        Calculator::Function(
+            "+",
+            2,
+            1,
+            [](Calculator::ArgumentsStack& stack) -> Calculator::NumberType
+            {
+                auto rightValue = stack.back();
+                stack.pop_back();
+
+                auto leftValue = stack.back();
+                stack.pop_back();
+
+                return leftValue * 10 + rightValue;
+            }
+        )
+    );
+
+    calc.setProfiling(true);
+    expected = calc.execute();
+    calc.setProfiling(false);
+
+    ASSERT_DOUBLE_EQ(calc.execute(), expected);
+
+    calc.deleteVariable("y");
+    ASSERT_THROW(calc.execute(), CalculationException);
+}
+
+TEST(Program, RegisterBackend)
+{
+    Calculator stackCalc;
+    Calculator registerCalc;
+
+    registerCalc.setBackend(Calculator::Backend::Register);
+
+    for (auto calc : {&stackCalc, &registerCalc})
+    {
+        calc->addBasicFunctions();
+        calc->addLogicFunctions();
+        calc->setVariable("x", 0.5);
+        calc->setVariable("y", -3);
+    }
+
+    for (auto expression : {"x",
+                            "2 * 3",
+                            "sin(x / 2 + y * x) + 1",
+                            "if(x > y, atan2(x, y) * (y - x), x) / 2 ^ y",
+                            "(x + y) * (x - y) / (x * y + 1) - ((y + 1) * (x + 2))"})
+    {
+        ASSERT_NO_THROW(stackCalc.setExpression(expression));
+        ASSERT_NO_THROW(registerCalc.setExpression(expression));
+
+        ASSERT_DOUBLE_EQ(registerCalc.execute(), stackCalc.execute()) << expression;
+    }
+
+    // Switching backend recompiles expression
+    registerCalc.setBackend(Calculator::Backend::Stack);
+    ASSERT_DOUBLE_EQ(registerCalc.execute(), stackCalc.execute());
+
+    registerCalc.setBackend(Calculator::Backend::Register);
+    registerCalc.setVariable("y", 4);
+    stackCalc.setVariable("y", 4);
+    ASSERT_DOUBLE_EQ(registerCalc.execute(), stackCalc.execute());
+
+    registerCalc.deleteVariable("x");
+    ASSERT_THROW(registerCalc.execute(), CalculationException);
+}
+
+TEST(Execution, NonThrowing)
+{
+    Calculator calc;
+    calc.addBasicFunctions();
+
+    ASSERT_EQ(calc.tryExecute().status, Calculator::ExecutionStatus::UnbalancedExpression);
+
+    calc.addFunction(
+        Calculator::Function(
+            "checked",
+            1,
+            4,
+            [](Calculator::ArgumentsStack& stack) -> Calculator::NumberType
+            {
+                auto value = stack.back();
+                stack.pop_back();
+
+                if (value < 0)
+                {
+                    throw CalculationException("Negative value");
+                }
+
+                return value;
+            }
+        )
+    );
+
+    ASSERT_NO_THROW(calc.setExpression("checked(x) * 2 + y"));
+
+    auto result = calc.tryExecute();
+    ASSERT_EQ(result.status, Calculator::ExecutionStatus::UndefinedVariable);
+    ASSERT_TRUE(std::isnan(result.value));
+
+    calc.setVariable("x", 4);
+    calc.setVariable("y", 1);
+
+    result = calc.tryExecute();
+    ASSERT_EQ(result.status, Calculator::ExecutionStatus::Success);
+    ASSERT_DOUBLE_EQ(result.value, 9);
+
+    // Row errors
+    std::vector<double> x(300, 1.5);
+    x[3] = -1;
+    x[299] = -2;
+
+    std::vector<double> results(x.size());
+    std::vector<uint64_t> errors((x.size() + 63) / 64);
+
+    ASSERT_THROW(calc.executeBatch({{"x", x.data()}}, x.size(), results.data()), CalculationException);
+
+    ASSERT_EQ(
+        calc.tryExecuteBatch({{"x", x.data()}}, x.size(), results.data(), errors.data()),
+        Calculator::ExecutionStatus::Success
+    );
+
+    for (std::size_t row = 0; row < x.size(); ++row)
+    {
+        bool failed = (errors[row / 64] >> (row % 64)) & 1U;
+
+        ASSERT_EQ(failed, x[row] < 0);
+
+        if (failed)
+        {
+            ASSERT_TRUE(std::isnan(results[row]));
+        }
+        else
+        {
+            ASSERT_DOUBLE_EQ(results[row], 4);
+        }
+    }
+
+    calc.deleteVariable("y");
+
+    ASSERT_EQ(
+        calc.tryExecuteBatch({{"x", x.data()}}, x.size(), results.data(), errors.data()),
+        Calculator::ExecutionStatus::UndefinedVariable
+    );
+
+    // Failed compilation leaves no partial expression
+    ASSERT_ANY_THROW(calc.setExpression("1 +"));
+
+    ASSERT_EQ(calc.tryExecute().status, Calculator::ExecutionStatus::UnbalancedExpression);
+
+    ASSERT_EQ(
+        calc.tryExecuteBatch({{"x", x.data()}}, x.size(), results.data(), errors.data()),
+        Calculator::ExecutionStatus::UnbalancedExpression
+    );
+
+    ASSERT_THROW(calc.sweep({{"x", x.data(), x.size()}}, results.data()), StatementException);
+    ASSERT_THROW(calc.simulate(10), StatementException);
+}
+
+TEST(Arrays, Reductions)
+{
+    Calculator calc;
+    calc.addBasicFunctions();
+    calc.addArrayFunctions();
+
+    // Sizes are not multiple of block
+    std::vector<double> prices(1000);
+    std::vector<double> quantities(1000);
+
+    double sum = 0;
+    double dot = 0;
+
+    for (std::size_t i = 0; i < prices.size(); ++i)
+    {
+        prices[i] = 1 + (i % 17) * 0.5;
+        quantities[i] = double(i % 5);
+
+        sum += prices[i];
+        dot += prices[i] * quantities[i];
+    }
+
+    calc.setArray("prices", prices);
+    calc.setArray("qty", quantities);
+    calc.setVariable("fee", 2);
+
+    ASSERT_NO_THROW(calc.setExpression("sum(prices)"));
+    ASSERT_NEAR(calc.execute(), sum, 1e-9);
+
+    ASSERT_NO_THROW(calc.setExpression("amin(prices) + amax(qty) * 10"));
+    ASSERT_DOUBLE_EQ(calc.execute(), 1 + 4 * 10);
+
+    // Element-wise minimum and maximum of two values
+    ASSERT_NO_THROW(calc.setExpression("amax(min(prices, 3) + max(qty, 2))"));
+    ASSERT_DOUBLE_EQ(calc.execute(), 3 + 4);
+
+    ASSERT_NO_THROW(calc.setExpression("min(fee, 1) + max(fee, 1)"));
+    ASSERT_DOUBLE_EQ(calc.execute(), 3);
+
+    ASSERT_NO_THROW(calc.setExpression("dot(prices, qty) / mean(prices)"));
+    ASSERT_NEAR(calc.execute(), dot / (sum / prices.size()), 1e-9);
+
+    // Scalar variables are broadcast
+    ASSERT_NO_THROW(calc.setExpression("sum(prices * qty + fee)"));
+    ASSERT_NEAR(calc.execute(), dot + 2 * prices.size(), 1e-9);
+
+    // Nested reduction
+    ASSERT_NO_THROW(calc.setExpression("sum(prices - mean(prices))"));
+    ASSERT_NEAR(calc.execute(), 0, 1e-9);
+
+    calc.setBackend(Calculator::Backend::Register);
+    ASSERT_NEAR(calc.execute(), 0, 1e-9);
+
+    // Reductions are broadcast in batch
+    ASSERT_NO_THROW(calc.setExpression("x * sum(qty)"));
+
+    std::vector<double> x = {1, 2, 3};
+    std::vector<double> results(x.size());
+
+    calc.executeBatch({{"x", x.data()}}, x.size(), results.data());
+
+    ASSERT_DOUBLE_EQ(results[2], 3 * 2000);
+
+    // Different sizes
+    calc.setArray("qty", {1, 2, 3});
+
+    ASSERT_NO_THROW(calc.setExpression("dot(prices, qty)"));
+    ASSERT_THROW(calc.execute(), CalculationException);
+    ASSERT_EQ(calc.tryExecute().status, Calculator::ExecutionStatus::ArraySizeMismatch);
+}
+
+TEST(Functions, Inlined)
+{
+    Calculator calc;
+    calc.addBasicFunctions();
+    calc.addLogicFunctions();
+    calc.addArrayFunctions();
+
+    ASSERT_NO_THROW(calc.defineFunction("clamp", {"x", "a", "b"}, "if(x < a, a, if(x > b, b, x))"));
+    ASSERT_NO_THROW(calc.defineFunction("square", {"x"}, "x * x"));
+    ASSERT_NO_THROW(calc.defineFunction("norm", {"x", "y"}, "sqrt(square(x) + square(y))"));
+
+    ASSERT_THROW(calc.defineFunction("broken", {"x"}, "x +"), StatementException);
+
+    calc.setVariable("v", 12);
+
+    ASSERT_NO_THROW(calc.setExpression("clamp(v, 0, 10) + norm(3, 4)"));
+    ASSERT_DOUBLE_EQ(calc.execute(), 15);
+
+    // Constant arguments are folded across call boundary
+    Calculator::LexemStack rpn;
+
+    ASSERT_NO_THROW(calc.setExpression("norm(3, 4) * v"));
+    calc.getRPN(rpn);
+
+    ASSERT_EQ(rpn.size(), 3);
+    ASSERT_DOUBLE_EQ(calc.execute(), 60);
+
+    // Parameter hides variable
+    calc.setVariable("x", 100);
+    calc.setArray("values", {1, 2, 3});
+
+    ASSERT_NO_THROW(calc.setExpression("sum(square(values)) + square(x - 98)"));
+    ASSERT_DOUBLE_EQ(calc.execute(), 18);
+
+    // Clamping with element-wise minimum and maximum
+    ASSERT_NO_THROW(calc.defineFunction("bound", {"x", "a", "b"}, "min(max(x, a), b)"));
+
+    ASSERT_NO_THROW(calc.setExpression("bound(v, 0, 10) + sum(bound(values, 2, 2.5))"));
+    ASSERT_DOUBLE_EQ(calc.execute(), 16.5);
+}
+
+TEST(Functions, Context)
+{
+    Calculator calc;
+    calc.addBasicFunctions();
+
+    double scale = 2;
+
+    calc.addFunction(
+        Calculator::Function(
+            "scaled",
+            1,
+            4,
+            [](Calculator::ArgumentsStack& stack, void* context) -> Calculator::NumberType
+            {
+                auto value = stack.back();
+                stack.pop_back();
+
+                return value * *static_cast<double*>(context);
+            },
+            &scale
+        )
+    );
+
+    calc.setVariable("x", 3);
+
+    ASSERT_NO_THROW(calc.setExpression("scaled(x) + 1"));
+    ASSERT_DOUBLE_EQ(calc.execute(), 7);
+
+    scale = 10;
+    ASSERT_DOUBLE_EQ(calc.execute(), 31);
+
+    double value = 0;
+    ASSERT_NO_THROW(calc.executeBatch({{"x", &value}}, 1, &value));
+    ASSERT_DOUBLE_EQ(value, 1);
+}
+
+TEST(Functions, Streams)
+{
+    Calculator calc;
+    calc.addBasicFunctions();
+    calc.addStreamFunctions();
+    calc.addArrayFunctions();
+    calc.addRandomFunctions();
+
+    ASSERT_THROW(calc.setExpression("rolling_mean(x, y)"), StatementException);
+
+    // Reductions have no call sites for states
+    ASSERT_THROW(calc.setExpression("sum(prev(x))"), StatementException);
+    ASSERT_THROW(calc.setExpression("1 + sum(p * uniform())"), StatementException);
+
+    ASSERT_NO_THROW(calc.setExpression("x - prev(x)"));
+
+    calc.setVariable("x", 5);
+    ASSERT_TRUE(std::isnan(calc.execute()));
+
+    calc.setVariable("x", 7);
+    ASSERT_DOUBLE_EQ(calc.execute(), 2);
+
+    ASSERT_NO_THROW(calc.setExpression("ema(x, 0.5) + rolling_mean(x, 2 + 1) * 1000"));
+
+    std::vector<double> x(600);
+    std::vector<double> expected(x.size());
+
+    double ema = 0;
+
+    for (std::size_t i = 0; i < x.size(); ++i)
+    {
+        x[i] = std::sin(static_cast<double>(i));
+
+        ema = (i == 0) ? x[i] : ema + 0.5 * (x[i] - ema);
+
+        auto first = (i < 2) ? 0 : i - 2;
+        double sum = 0;
+
+        for (auto j = first; j <= i; ++j)
+        {
+            sum += x[j];
+        }
+
+        expected[i] = ema + sum / static_cast<double>(i - first + 1) * 1000;
+    }
+
+    // Streaming
+    for (std::size_t i = 0; i < x.size(); ++i)
+    {
+        calc.setVariable("x", x[i]);
+
+        ASSERT_NEAR(calc.execute(), expected[i], 1e-9);
+    }
+
+    // Batch over series
+    calc.resetStreams();
+
+    std::vector<double> results(x.size());
+
+    ASSERT_NO_THROW(calc.executeBatch({{"x", x.data()}}, x.size(), results.data()));
+
+    for (std::size_t i = 0; i < x.size(); ++i)
+    {
+        ASSERT_NEAR(results[i], expected[i], 1e-9);
+    }
+}
+
+TEST(Functions, Random)
+{
+    Calculator calc;
+    calc.addBasicFunctions();
+    calc.addRandomFunctions();
+    calc.addStreamFunctions();
+
+    ASSERT_NO_THROW(calc.setExpression("uniform() + normal() * k"));
+
+    calc.setVariable("k", 0);
+
+    calc.setRandomSeed(42);
+
+    std::vector<double> draws;
+
+    for (int i = 0; i < 3; ++i)
+    {
+        draws.push_back(calc.execute());
+
+        ASSERT_GE(draws.back(), 0);
+        ASSERT_LT(draws.back(), 1);
+    }
+
+    ASSERT_NE(draws[0], draws[1]);
+
+    // Draws depend only on seed
+    calc.setRandomSeed(42);
+
+    ASSERT_EQ(calc.execute(), draws[0]);
+
+    calc.setVariable("k", 2);
+
+    auto single = calc.simulate(100000, 1);
+    auto parallel = calc.simulate(100000, 4);
+
+    ASSERT_EQ(single.paths, 100000u);
+    ASSERT_EQ(single.mean, parallel.mean);
+    ASSERT_EQ(single.variance, parallel.variance);
+    ASSERT_EQ(single.min, parallel.min);
+    ASSERT_EQ(single.max, parallel.max);
+
+    // Variance of uniform is 1/12
+    ASSERT_NEAR(single.mean, 0.5, 4 * single.standardError);
+    ASSERT_NEAR(single.variance, 4 + 1.0 / 12, 0.1);
+
+    ASSERT_NO_THROW(calc.setExpression("prev(uniform())"));
+    ASSERT_THROW(calc.simulate(10), std::invalid_argument);
+}
+
+TEST(Functions, Solver)
+{
+    Calculator calc;
+    calc.addBasicFunctions();
+    calc.addInterpolationFunctions();
+
+    const std::size_t rows = 1000;
+
+    std::vector<double> p(rows);
+    std::vector<double> targets(rows);
+
+    for (std::size_t i = 0; i < rows; ++i)
+    {
+        p[i] = 1 + static_cast<double>(i) / 100;
+        targets[i] = static_cast<double>(i) / 10 - 20;
+    }
+
+    ASSERT_NO_THROW(calc.setExpression("x^3 + p * x"));
+
+    Calculator::SolverOptions options;
+    options.lower = -10;
+    options.upper = 10;
+
+    std::vector<double> roots(rows);
+    std::vector<uint32_t> iterations(rows);
+    std::vector<Calculator::SolverStatus> statuses(rows);
+
+    for (auto method : {Calculator::SolverMethod::Brent, Calculator::SolverMethod::Newton})
+    {
+        options.method = method;
+
+        calc.solveBatch("x", {{"p", p.data()}}, rows, targets.data(), options,
+                        roots.data(), iterations.data(), statuses.data(), 1);
+
+        for (std::size_t i = 0; i < rows; ++i)
+        {
+            ASSERT_EQ(statuses[i], Calculator::SolverStatus::Converged);
+            ASSERT_LE(iterations[i], options.maxIterations);
+            ASSERT_NEAR(std::pow(roots[i], 3) + p[i] * roots[i], targets[i], 1e-9);
+        }
+
+        // Rows don't depend on number of threads
+        std::vector<double> parallel(rows);
+
+        calc.solveBatch("x", {{"p", p.data()}}, rows, targets.data(), options,
+                        parallel.data(), nullptr, nullptr, 4);
+
+        ASSERT_EQ(roots, parallel);
+    }
+
+    // Interpolation has no derivative, so secant is used
+    calc.addTable("curve", {0, 1, 2, 3}, {0, 1, 4, 9});
+
+    ASSERT_NO_THROW(calc.setExpression("interp_cubic(curve, x)"));
+
+    calc.solveBatch("x", {}, 1, nullptr, options, roots.data(), iterations.data(), statuses.data());
+
+    ASSERT_EQ(statuses[0], Calculator::SolverStatus::Converged);
+    ASSERT_NEAR(roots[0], 0, 1e-9);
+
+    // Root is not bracketed
+    ASSERT_NO_THROW(calc.setExpression("x^2 + 1"));
+
+    options.method = Calculator::SolverMethod::Brent;
+
+    calc.solveBatch("x", {}, 1, nullptr, options, roots.data(), iterations.data(), statuses.data());
+
+    ASSERT_EQ(statuses[0], Calculator::SolverStatus::NoBracket);
+
+    ASSERT_THROW(
+        calc.solveBatch("y", {}, 1, nullptr, options, roots.data(), nullptr, nullptr),
+        std::invalid_argument
+    );
+
+    // Reductions are computed once for all rows
+    calc.addArrayFunctions();
+    calc.setArray("a", {1, 2, 3});
+
+    ASSERT_NO_THROW(calc.setExpression("sum(a) * x - 12"));
+
+    calc.solveBatch("x", {}, 1, nullptr, options, roots.data(), iterations.data(), statuses.data());
+
+    ASSERT_EQ(statuses[0], Calculator::SolverStatus::Converged);
+    ASSERT_NEAR(roots[0], 2, 1e-9);
+
+    ASSERT_NO_THROW(calc.setExpression("sum(a * x) - 12"));
+
+    ASSERT_THROW(
+        calc.solveBatch("x", {}, 1, nullptr, options, roots.data(), nullptr, nullptr),
+        std::invalid_argument
+    );
+
+    ASSERT_NO_THROW(calc.setExpression("sum(a * p) - x"));
+
+    ASSERT_THROW(
+        calc.solveBatch("x", {{"p", p.data()}}, 1, nullptr, options, roots.data(), nullptr, nullptr),
+        std::invalid_argument
+    );
+}
+
+TEST(Functions, Integration)
+{
+    Calculator calc;
+    calc.addBasicFunctions();
+    calc.addIntegrationFunctions();
+    calc.addConstants();
+
+    calc.setVariable("k", 2);
+
+    ASSERT_NO_THROW(calc.setExpression("integrate(x^2, x, 0, 3)"));
+    ASSERT_NEAR(calc.execute(), 9, 1e-12);
+
+    ASSERT_NO_THROW(calc.setExpression("1 + integrate(sin(k * x), x, 0, Pi / k)"));
+    ASSERT_NEAR(calc.execute(), 2, 1e-12);
+
+    // Singular derivative is refined adaptively
+    ASSERT_NO_THROW(calc.setExpression("integrate(sqrt(x), x, 0, 1)"));
+    ASSERT_NEAR(calc.execute(), 2.0 / 3, 1e-9);
+
+    // Reversed bounds
+    ASSERT_NO_THROW(calc.setExpression("integrate(exp(0 - x * x), x, k, 0)"));
+    ASSERT_NEAR(calc.execute(), -std::sqrt(M_PI) / 2 * std::erf(2), 1e-12);
+
+    Calculator::QuadratureOptions options;
+    options.method = Calculator::QuadratureMethod::GaussLegendre;
+    options.points = 5;
+
+    calc.setQuadrature(options);
+
+    // Exact for polynomials up to 2 * points - 1 degree
+    ASSERT_NO_THROW(calc.setExpression("integrate(x^9 + k, x, 0 - 1, 2)"));
+    ASSERT_NEAR(calc.execute(), (1024.0 - 1) / 10 + 6, 1e-10);
+
+    options.points = 0;
+
+    ASSERT_THROW(calc.setQuadrature(options), std::invalid_argument);
+
+    ASSERT_THROW(calc.setExpression("integrate(x, 1, 0, 1)"), StatementException);
+    ASSERT_THROW(calc.setExpression("integrate(x, x, 0, x)"), StatementException);
+}
+
+TEST(Functions, Interpolation)
+{
+    Calculator calc;
+    calc.addBasicFunctions();
+    calc.addInterpolationFunctions();
+
+    // Uniform and non uniform grids
+    calc.addTable("curve", {0, 1, 2, 3}, {0, 10, 20, 0});
+    calc.addTable("rates", {0, 0.5, 2, 10}, {1, 2, 4, 8});
+
+    ASSERT_THROW(calc.addTable("broken", {0, 2, 1}, {0, 1, 2}), std::invalid_argument);
+
+    calc.setVariable("t", 2.5);
+
+    ASSERT_NO_THROW(calc.setExpression("interp(curve, t)"));
+    ASSERT_DOUBLE_EQ(calc.execute(), 10);
+
+    ASSERT_NO_THROW(calc.setExpression("interp_step(curve, t) + interp_step(rates, t)"));
+    ASSERT_DOUBLE_EQ(calc.execute(), 24);
+
+    calc.setVariable("t", 1.25);
+
+    ASSERT_NO_THROW(calc.setExpression("interp(rates, t)"));
+    ASSERT_DOUBLE_EQ(calc.execute(), 3);
+
+    // Points out of table are clamped
+    calc.setVariable("t", -5);
+    ASSERT_DOUBLE_EQ(calc.execute(), 1);
+
+    calc.setVariable("t", 50);
+    ASSERT_DOUBLE_EQ(calc.execute(), 8);
+
+    // Spline goes through points
+    ASSERT_NO_THROW(calc.setExpression("interp_cubic(curve, t)"));
+
+    for (double point : {0.0, 1.0, 2.0, 3.0})
+    {
+        calc.setVariable("t", point);
+        ASSERT_NEAR(calc.execute(), point == 3 ? 0 : point * 10, 1e-12);
+    }
+
+    ASSERT_NO_THROW(calc.setExpression("interp(t, 1)"));
+    ASSERT_THROW(calc.execute(), CalculationException);
+
+    // Table indices are not saved
+    ASSERT_NO_THROW(calc.setExpression("interp(curve, t) + 1"));
+
+    std::stringstream stream;
+    ASSERT_THROW(calc.saveExpression(stream), SerializationException);
+}
+
+TEST(Optimization, Polynomials)
+{
+    Calculator calc;
+    calc.addBasicFunctions();
+
+    auto reference = [](double x)
+    {
+        double result = 0;
+
+        for (int i = 0; i < 12; ++i)
+        {
+            result += (i + 1) * 0.1 * std::pow(x, i);
+        }
+
+        return result;
+    };
+
+    std::string expression = "0.1";
+
+    for (int i = 1; i < 12; ++i)
+    {
+        expression += " + " + std::to_string((i + 1) * 0.1) + " * x ^ " + std::to_string(i);
+    }
+
+    ASSERT_NO_THROW(calc.setExpression(expression + " + sin(y)"));
+
+    // Estrin's scheme
+    Calculator::LexemStack rpn;
+    calc.getRPN(rpn);
+
+    ASSERT_EQ(rpn.size(), 5);
+
+    calc.setVariable("y", 0);
+
+    for (double x : {-1.5, 0.0, 0.3, 2.0})
+    {
+        calc.setVariable("x", x);
+        ASSERT_NEAR(calc.execute(), reference(x), 1e-9 * std::abs(reference(x)) + 1e-12);
+    }
+
+    // Horner's scheme with division
+    ASSERT_NO_THROW(calc.setExpression("(x ^ 2 + 2 * x + 1) / 2 - x"));
+    calc.getRPN(rpn);
+
+    ASSERT_EQ(rpn.size(), 2);
+
+    calc.setVariable("x", 3);
+    ASSERT_DOUBLE_EQ(calc.execute(), 5);
+
+    // Polynomials are saved as expressions
+    std::stringstream stream;
+
+    ASSERT_NO_THROW(calc.saveExpression(stream));
+
+    Calculator loaded;
+    ASSERT_NO_THROW(loaded.loadExpression(stream));
+
+    loaded.setVariable("x", 3);
+    ASSERT_DOUBLE_EQ(loaded.execute(), 5);
+
+    // Different variables are not mixed
+    calc.setVariable("y", 2);
+    ASSERT_NO_THROW(calc.setExpression("x * x * y + y ^ 2"));
+    ASSERT_DOUBLE_EQ(calc.execute(), 22);
+
+    // Polynomials keep order of operands
+    calc.setVariable("x", 2);
+    calc.setVariable("y", 3);
+
+    ASSERT_NO_THROW(calc.setExpression("(x ^ 2 + 1) / (y ^ 2 + 1)"));
+    ASSERT_DOUBLE_EQ(calc.execute(), 0.5);
+
+    ASSERT_NO_THROW(calc.setExpression("(x * x + 2 * x + 1) - (y * y + 3 * y + 2)"));
+    ASSERT_DOUBLE_EQ(calc.execute(), -11);
+
+    ASSERT_NO_THROW(calc.setExpression("atan2(x ^ 2 + 1, y ^ 2 + 1) + (x ^ 3 - 1) / 2"));
+    ASSERT_DOUBLE_EQ(calc.execute(), std::atan2(5, 10) + 3.5);
+
+    // Factored forms are not expanded, so
+    // there is no cancellation near roots
+    Calculator unoptimized;
+    unoptimized.addBasicFunctions();
+
+    for (auto&& [factored, root] : {std::make_pair("(x - 1000) ^ 4", 1000.0),
+                                    std::make_pair("(x - 1) ^ 8 + x * x", 1.0),
+                                    std::make_pair("(x - 3) ^ 16 * (x ^ 2 + 1)", 3.0),
+                                    std::make_pair("(x - 2) * (x - 2) * (x - 2)", 2.0)})
+    {
+        ASSERT_NO_THROW(calc.setExpression(factored));
+        ASSERT_NO_THROW(unoptimized.setExpression(factored, false));
+
+        for (double x : {root + 1e-3, root - 1e-3})
+        {
+            calc.setVariable("x", x);
+            unoptimized.setVariable("x", x);
+
+            ASSERT_DOUBLE_EQ(calc.execute(), unoptimized.execute());
+        }
+    }
+}
+
+TEST(Optimization, Specialization)
+{
+    Calculator calc;
+    calc.addBasicFunctions();
+
+    calc.setVariable("rate", 0.5);
+    calc.setVariable("fee", 2);
+    calc.setVariable("x", 4);
+
+    ASSERT_NO_THROW(calc.setExpression("x * (rate + 1) ^ 2 + fee * 3 + rate * x"));
+    ASSERT_DOUBLE_EQ(calc.execute(), 4 * 2.25 + 6 + 2);
+
+    Calculator::LexemStack general;
+    calc.getRPN(general);
+
+    ASSERT_THROW(calc.specialize({"unknown"}), std::invalid_argument);
+
+    ASSERT_NO_THROW(calc.specialize({"rate", "fee"}));
+
+    Calculator::LexemStack specialized;
+    calc.getRPN(specialized);
+
+    ASSERT_LT(specialized.size(), general.size());
+    ASSERT_DOUBLE_EQ(calc.execute(), 17);
+
+    // Frozen values are not changed
+    calc.setVariable("rate", 1);
+    calc.setVariable("x", 2);
+
+    ASSERT_DOUBLE_EQ(calc.execute(), 2 * 2.25 + 6 + 1);
+
+    calc.generalize();
+    ASSERT_DOUBLE_EQ(calc.execute(), 2 * 4 + 6 + 2);
+
+    // Specialization with new values
+    ASSERT_NO_THROW(calc.specialize({"rate"}));
+    ASSERT_DOUBLE_EQ(calc.execute(), 16);
+
+    calc.setVariable("fee", 0);
+    ASSERT_DOUBLE_EQ(calc.execute(), 10);
+}
+
+TEST(Registry, Shared)
+{
+    Calculator first;
+    first.addBasicFunctions();
+    first.addConstants();
+
+    Calculator second;
+    second.addConstants();
+    second.addBasicFunctions();
+
+    ASSERT_NO_THROW(first.setExpression("sin(x) + Pi"));
+    ASSERT_NO_THROW(second.setExpression("sin(x) + Pi"));
+
+    Calculator::LexemStack firstRpn;
+    Calculator::LexemStack secondRpn;
+
+    first.getRPN(firstRpn);
+    second.getRPN(secondRpn);
+
+    // Shared functions are referenced as constants
+    static_assert(
+        std::is_same_v<
+            std::variant_alternative_t<0, Calculator::Lexem::ValueType>,
+            const Calculator::Function*
+        >,
+        "Lexems can't change shared functions"
+    );
+
+    // Built-in functions are not copied
+    ASSERT_EQ(
+        std::get<const Calculator::Function*>(firstRpn[1].value),
+        std::get<const Calculator::Function*>(secondRpn[1].value)
+    );
+
+    // Own function hides shared one
+    first.addFunction(
+        Calculator::Function(
+            "sin",
+            1,
+            4,
+            [](Calculator::ArgumentsStack& stack) -> Calculator::NumberType
+            {
+                stack.pop_back();
+
+                return 42;
+            }
+        )
+    );
+
+    first.setVariable("x", 0);
+    second.setVariable("x", 0);
+
+    ASSERT_DOUBLE_EQ(first.execute(), 42 + M_PI);
+    ASSERT_DOUBLE_EQ(second.execute(), M_PI);
+
+    // Shared functions are kept after own ones
+    first.addLogicFunctions();
+
+    ASSERT_NO_THROW(first.setExpression("if(x < 1, cos(x), sin(x))"));
+    ASSERT_DOUBLE_EQ(first.execute(), 1);
+}
+
+TEST(Serialization, Store)
+{
+    std::vector<std::string_view> expressions = {
+        "sin(x) * 2 + y",
+        "3 * x^3 - 2 * x^2 + x - 5",
+        "if (x > y) {x} {y} + Pi"
+    };
+
+    Calculator source;
+    source.addBasicFunctions();
+    source.addLogicFunctions();
+    source.addConstants();
+
+    auto path = testing::TempDir() + "expressions.store";
+
+    {
+        std::ofstream file(path, std::ios::binary);
+        ASSERT_NO_THROW(source.saveStore(file, expressions));
+    }
+
+    ExpressionStore store(path);
+
+    ASSERT_EQ(store.size(), expressions.size());
+
+    // Worker has own registry and variables
+    Calculator worker;
+    worker.addLogicFunctions();
+    worker.addBasicFunctions();
+
+    ASSERT_NO_THROW(worker.bindStore(store));
+
+    ASSERT_THROW(worker.executeStored(0), CalculationException);
+
+    worker.setVariable("x", 0.7);
+    worker.setVariable("y", 1.5);
+
+    for (std::size_t i = 0; i < expressions.size(); ++i)
+    {
+        source.setExpression(expressions[i]);
+        source.setVariable("x", 0.7);
+        source.setVariable("y", 1.5);
+
+        ASSERT_DOUBLE_EQ(worker.executeStored(i), source.execute());
+    }
+
+    ASSERT_THROW(worker.executeStored(expressions.size()), std::invalid_argument);
+
+    // Store in memory, references unknown function
+    std::stringstream stream;
+    source.saveStore(stream, {"sin(x)"});
+
+    auto data = stream.str();
+    std::vector<uint64_t> buffer((data.size() + 7) / 8);
+    std::copy(data.begin(), data.end(), reinterpret_cast<char*>(buffer.data()));
+
+    ExpressionStore memoryStore(buffer.data(), data.size());
+
+    Calculator empty;
+
+    ASSERT_THROW(empty.bindStore(memoryStore), SerializationException);
+
+    // Damaged program
+    ASSERT_THROW(ExpressionStore(buffer.data(), data.size() - 4), SerializationException);
+}
+
 int main(int argc, char** argv)
 {
     testing::InitGoogleTest(&argc, argv);